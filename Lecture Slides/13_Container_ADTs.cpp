@@ -2,12 +2,18 @@
  * 
  * Example of an abstract data type representing a set of integers
  *
+ * To benchmark the IntSet instead of running the demo:
+ * $ g++ -std=c++11 -O2 -DNDEBUG -DINTSET_BENCHMARK 13_Container_ADTs.cpp
+ *
  * by Andrew DeOrio <awdeorio@umich.edu>
  * 2013-05-30
  */
 
 #include <iostream> //cout, endl
 #include <cassert>  //assert
+#ifdef INTSET_BENCHMARK
+#include "IntSet_Benchmark.h" //benchmark_IntSet
+#endif
 using namespace std;
 
 
@@ -38,6 +44,22 @@ class IntSet {
   //EFFECTS: prints set
   void print() const;
 
+  //EFFECTS: returns the number of elements in set that are less than v
+  int rank(int v) const;
+
+  //REQUIRES: 0 <= k < |set|
+  //EFFECTS: returns the k-th smallest element in set, counting from 0
+  int select(int k) const;
+
+  //EFFECTS: returns the number of elements in set that are >= lo and <= hi
+  int count_range(int lo, int hi) const;
+
+  //MODIFIES: first, last
+  //EFFECTS: sets [first, last) to the elements in set that are >= lo and
+  //         <= hi, in increasing order.  The pointers are invalidated by
+  //         insert() and remove().
+  void range(int lo, int hi, const int * &first, const int * &last) const;
+
   //maximum size of a set
   static const int ELTS_CAPACITY = 100;
 
@@ -51,6 +73,12 @@ private:
 
   //EFFECTS: returns the index of v if it exists in the set, ELTS_CAPACITY otherwise
   int indexOf(int v) const;
+
+  //EFFECTS: returns the index of the first element >= v, elts_size if none
+  int lower_bound(int v) const;
+
+  //EFFECTS: returns the index of the first element > v, elts_size if none
+  int upper_bound(int v) const;
 };
 
 
@@ -128,7 +156,78 @@ void IntSet::print() const {
 }
 
 
+int IntSet::lower_bound(int v) const {
+  int left = 0;
+  int right = elts_size; //answer is in [left, right]
+
+  while (left < right) {
+    int middle = left + (right - left)/2;
+    if (elts[middle] < v)
+      left = middle+1;
+    else
+      right = middle;
+  }
+
+  return left;
+}
+
+
+int IntSet::upper_bound(int v) const {
+  int left = 0;
+  int right = elts_size; //answer is in [left, right]
+
+  while (left < right) {
+    int middle = left + (right - left)/2;
+    if (elts[middle] <= v)
+      left = middle+1;
+    else
+      right = middle;
+  }
+
+  return left;
+}
+
+
+int IntSet::rank(int v) const {
+  return lower_bound(v);
+}
+
+
+int IntSet::select(int k) const {
+  assert(0 <= k && k < elts_size); //REQUIRES k is a valid position
+  return elts[k];
+}
+
+
+int IntSet::count_range(int lo, int hi) const {
+  if (hi < lo) return 0;
+  return upper_bound(hi) - lower_bound(lo);
+}
+
+
+void IntSet::range(int lo, int hi,
+                   const int * &first, const int * &last) const {
+  first = elts + lower_bound(lo);
+  last = (hi < lo) ? first : elts + upper_bound(hi);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
+#ifdef INTSET_BENCHMARK
+int main(int argc, char *argv[]) {
+  int capacity = IntSet::ELTS_CAPACITY;
+  vector<int> sizes;
+  sizes.push_back(10);
+  sizes.push_back(capacity);
+  vector<IntSetWorkload> workloads =
+    IntSet_workloads(argc, argv, sizes, capacity);
+
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    IntSet is;
+    benchmark_IntSet(cout, "13_IntSet", is, workloads[i]);
+  }
+}
+#else
 int main () {
   IntSet is;
   is.insert(7);
@@ -137,4 +236,28 @@ int main () {
   is.print();
   is.remove(7);
   is.print();
+
+  for (int v = 10; v > 0; v -= 2) is.insert(v);
+  is.print();
+  cout << "rank(7) = " << is.rank(7) << endl;
+  cout << "select(1) = " << is.select(1) << endl;
+  cout << "count_range(3, 8) = " << is.count_range(3, 8) << endl;
+
+  const int *first, *last;
+  is.range(3, 8, first, last);
+  cout << "range(3, 8) = { ";
+  for (const int *p = first; p != last; ++p)
+    cout << *p << " ";
+  cout << "}" << endl;
 }
+
+/* output
+{ 4 7 } 
+{ 4 } 
+{ 2 4 6 8 10 } 
+rank(7) = 3
+select(1) = 4
+count_range(3, 8) = 3
+range(3, 8) = { 4 6 8 }
+ */
+#endif
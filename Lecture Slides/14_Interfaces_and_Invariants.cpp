@@ -3,6 +3,14 @@
  * Example of an abstract base class representing a set of integers.
  * There are two implementations: sorted and unsorted
  *
+ * The implementations are written against StaticIntSet, a compile-time
+ * interface, so that code which knows the concrete type pays no virtual call.
+ * IntSetAdapter wraps either one in the run-time IntSet interface.
+ *
+ * To benchmark both implementations instead of running the demo:
+ * $ g++ -std=c++11 -O2 -DNDEBUG -DINTSET_BENCHMARK 14_Interfaces_and_Invariants.cpp
+ * $ ./a.out --mix=read --dist=zipf
+ *
  * by Andrew DeOrio <awdeorio@umich.edu>
  * 2013-05-30
  */
@@ -10,6 +18,10 @@
 #include <iostream> //cout, endl
 #include <cassert>  //assert
 #include <string>   //needed for factory function
+#include "BloomFilter.h" //needed for BloomIntSet
+#ifdef INTSET_BENCHMARK
+#include "IntSet_Benchmark.h" //benchmark_IntSet
+#endif
 using namespace std;
 
 
@@ -44,7 +56,56 @@ public:
 
 
 ////////////////////////////////////////////////////////////////////////////////
-class IntSetUnsorted : public IntSet {
+template <typename Derived>
+class StaticIntSet {
+  // OVERVIEW: compile-time version of the IntSet interface.  An implementation
+  //           derives from StaticIntSet<itself> and defines insert(), remove(),
+  //           query(), size() and print() without "virtual".  Each call below
+  //           is resolved at compile time and can be inlined.
+ public:
+
+  //REQUIRES: set is not full
+  //MODIFIES: this
+  //EFFECTS: set=set+{v}
+  void insert(int v) { derived().insert(v); }
+
+  //REQUIRES: v is in set
+  //MODIFIES: this
+  //EFFECTS: set=set-{v}
+  void remove(int v) { derived().remove(v); }
+
+  //EFFECTS: returns true if v is in set,
+  //false otherwise
+  bool query(int v) const { return derived().query(v); }
+
+  //EFFECTS: returns |set|
+  int size() const { return derived().size(); }
+
+  //EFFECTS: prints set
+  void print() const { derived().print(); }
+
+  //EFFECTS: returns pointers to the first and past-the-last elements of set,
+  //         in no particular order.  The pointers are invalidated by
+  //         insert() and remove().
+  const int * begin() const { return derived().begin(); }
+  const int * end() const { return derived().end(); }
+
+  //maximum size of a set
+  static const int ELTS_CAPACITY = IntSet::ELTS_CAPACITY;
+
+ protected:
+  // only derived classes are created and destroyed, never a bare StaticIntSet
+  StaticIntSet() {}
+  ~StaticIntSet() {}
+
+ private:
+  Derived & derived() { return static_cast<Derived &>(*this); }
+  const Derived & derived() const { return static_cast<const Derived &>(*this); }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+class IntSetUnsorted : public StaticIntSet<IntSetUnsorted> {
   // OVERVIEW: mutable set of ints with bounded size, unsorted order
 public:
 
@@ -54,22 +115,26 @@ public:
   //REQUIRES: set is not full
   //MODIFIES: this
   //EFFECTS: set=set+{v}
-  virtual void insert(int v);
+  void insert(int v);
 
   //REQUIRES: v is in set
   //MODIFIES: this
   //EFFECTS: set=set-{v}
-  virtual void remove(int v);
+  void remove(int v);
 
   //EFFECTS: returns true if v is in set,
   //false otherwise
-  virtual bool query(int v) const;
+  bool query(int v) const;
 
   //EFFECTS: returns |set|
-  virtual int size() const;
+  int size() const;
 
   //EFFECTS: prints set
-  virtual void print() const;
+  void print() const;
+
+  //EFFECTS: returns pointers to the first and past-the-last elements of set
+  const int * begin() const { return elts; }
+  const int * end() const { return elts + elts_size; }
 
 private:
   //Represent a set of size N as an sorted set of integers, with no 
@@ -88,7 +153,7 @@ private:
 
 
 ////////////////////////////////////////////////////////////////////////////////
-class IntSetSorted : public IntSet {
+class IntSetSorted : public StaticIntSet<IntSetSorted> {
   // OVERVIEW: mutable set of ints with bounded size, in sorted order
  public:
 
@@ -98,22 +163,43 @@ class IntSetSorted : public IntSet {
   //REQUIRES: set is not full
   //MODIFIES: this
   //EFFECTS: set=set+{v}
-  virtual void insert(int v);
+  void insert(int v);
 
   //REQUIRES: v is in set
   //MODIFIES: this
   //EFFECTS: set=set-{v}
-  virtual void remove(int v);
+  void remove(int v);
 
   //EFFECTS: returns true if v is in set,
   //false otherwise
-  virtual bool query(int v) const;
+  bool query(int v) const;
 
   //EFFECTS: returns |set|
-  virtual int size() const;
+  int size() const;
 
   //EFFECTS: prints set
-  virtual void print() const;
+  void print() const;
+
+  //EFFECTS: returns pointers to the first and past-the-last elements of set,
+  //         in increasing order
+  const int * begin() const { return elts; }
+  const int * end() const { return elts + elts_size; }
+
+  //EFFECTS: returns the number of elements in set that are less than v
+  int rank(int v) const;
+
+  //REQUIRES: 0 <= k < |set|
+  //EFFECTS: returns the k-th smallest element in set, counting from 0
+  int select(int k) const;
+
+  //EFFECTS: returns the number of elements in set that are >= lo and <= hi
+  int count_range(int lo, int hi) const;
+
+  //MODIFIES: first, last
+  //EFFECTS: sets [first, last) to the elements in set that are >= lo and
+  //         <= hi, in increasing order.  The pointers are invalidated by
+  //         insert() and remove().
+  void range(int lo, int hi, const int * &first, const int * &last) const;
 
 private:
   //Represent a set of size N as an sorted set of integers, with no 
@@ -126,6 +212,12 @@ private:
   //EFFECTS: returns the index of v if it exists in the set, ELTS_CAPACITY otherwise
   int indexOf(int v) const;
 
+  //EFFECTS: returns the index of the first element >= v, elts_size if none
+  int lower_bound(int v) const;
+
+  //EFFECTS: returns the index of the first element > v, elts_size if none
+  int upper_bound(int v) const;
+
   //EFFECTS: returns true if representation invariant holds
   bool check_invariant() const;
 };
@@ -285,6 +377,66 @@ void IntSetSorted::print() const {
 }
 
 
+int IntSetSorted::lower_bound(int v) const {
+  int left = 0;
+  int right = elts_size; //answer is in [left, right]
+
+  while (left < right) {
+    int middle = left + (right - left)/2;
+    if (elts[middle] < v)
+      left = middle+1;
+    else
+      right = middle;
+  }
+
+  return left;
+}
+
+
+int IntSetSorted::upper_bound(int v) const {
+  int left = 0;
+  int right = elts_size; //answer is in [left, right]
+
+  while (left < right) {
+    int middle = left + (right - left)/2;
+    if (elts[middle] <= v)
+      left = middle+1;
+    else
+      right = middle;
+  }
+
+  return left;
+}
+
+
+int IntSetSorted::rank(int v) const {
+  assert(check_invariant());
+  return lower_bound(v);
+}
+
+
+int IntSetSorted::select(int k) const {
+  assert(check_invariant());
+  assert(0 <= k && k < elts_size); //REQUIRES k is a valid position
+  return elts[k];
+}
+
+
+int IntSetSorted::count_range(int lo, int hi) const {
+  assert(check_invariant());
+  if (hi < lo) return 0;
+  return upper_bound(hi) - lower_bound(lo);
+}
+
+
+void IntSetSorted::range(int lo, int hi,
+                         const int * &first, const int * &last) const {
+  assert(check_invariant());
+  first = elts + lower_bound(lo);
+  last = (hi < lo) ? first : elts + upper_bound(hi);
+}
+
+
 bool IntSetSorted::check_invariant() const {
   for (int i=0; i<elts_size-1; ++i) {
     if (elts[i] >= elts[i+1]) {
@@ -295,13 +447,173 @@ bool IntSetSorted::check_invariant() const {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+template <typename Impl>
+class BloomIntSet : public StaticIntSet<BloomIntSet<Impl> > {
+  // OVERVIEW: the set Impl with a blocked Bloom filter in front of query().
+  //           Most queries for non-members are answered by the filter with
+  //           one cache line probe and never reach Impl.
+  //
+  //           The filter cannot forget keys, so remove() leaves stale bits
+  //           behind, which only cost extra false positives.  Once the
+  //           number of removes since the last rebuild passes
+  //           rebuild_fraction of the number of elements, the next query()
+  //           rebuilds the filter from the elements of Impl.  A small set
+  //           is rebuilt often, but cheaply, in the same memory unless the
+  //           filter is too small or much too big.
+  //
+  //           A set of fewer than MIN_FILTERED elements is searched about as
+  //           fast as the filter is probed, so query() asks Impl directly.
+ public:
+
+  static const int MIN_FILTERED = 16;
+
+  //REQUIRES: expected > 0, rebuild_fraction > 0
+  //EFFECTS: creates an empty set whose filter is sized for expected elements
+  BloomIntSet(int expected_in = IntSet::ELTS_CAPACITY,
+              double rebuild_fraction_in = 0.1)
+    : filter(expected_in), stale(0), filtered(0), false_positives(0),
+      rebuild_fraction(rebuild_fraction_in) {
+    assert(rebuild_fraction > 0);
+  }
+
+  //REQUIRES: Impl can hold v
+  //MODIFIES: this
+  //EFFECTS: set=set+{v}
+  void insert(int v) {
+    impl.insert(v);
+    if (impl.size() > filter.capacity()) {
+      rebuild(2 * impl.size()); //outgrew the filter
+    } else {
+      filter.insert(v);
+    }
+  }
+
+  //REQUIRES: v is in set
+  //MODIFIES: this
+  //EFFECTS: set=set-{v}
+  void remove(int v) {
+    impl.remove(v);
+    ++stale;
+  }
+
+  //MODIFIES: the filter and statistics, but not the set
+  //EFFECTS: returns true if v is in set,
+  //false otherwise
+  bool query(int v) const {
+    if (impl.size() < MIN_FILTERED) return impl.query(v);
+    // stale keys are measured against the live ones, not the capacity,
+    // which may be far bigger
+    int live = impl.size();
+    if (stale > rebuild_fraction * live) rebuild(2 * live);
+    if (!filter.maybe_contains(v)) {
+      ++filtered;
+      return false;
+    }
+    bool found = impl.query(v);
+    if (!found) ++false_positives;
+    return found;
+  }
+
+  //EFFECTS: returns |set|
+  int size() const { return impl.size(); }
+
+  //EFFECTS: prints set
+  void print() const { impl.print(); }
+
+  //EFFECTS: returns pointers to the first and past-the-last elements of set
+  const int * begin() const { return impl.begin(); }
+  const int * end() const { return impl.end(); }
+
+  //EFFECTS: returns the fraction of queries for non-members that the filter
+  //         let through to Impl, 0 if there were none.  Queries made while
+  //         the set was too small to use the filter don't count.
+  double false_positive_rate() const {
+    long long negatives = filtered + false_positives;
+    return negatives ? double(false_positives) / negatives : 0;
+  }
+
+ private:
+  Impl impl;
+
+  //query() is const but rebuilds the filter lazily and keeps statistics
+  mutable BloomFilter filter;
+  mutable int stale;                  //removes since the filter was built
+  mutable long long filtered;         //queries answered by the filter alone
+  mutable long long false_positives;  //queries the filter let through wrongly
+  double rebuild_fraction;
+
+  //REQUIRES: expected > 0
+  //MODIFIES: filter, stale
+  //EFFECTS:  rebuilds the filter from the elements of impl, sized for
+  //          expected elements, or for up to four times that if the filter
+  //          already is
+  void rebuild(int expected) const {
+    if (expected <= filter.capacity() && filter.capacity() <= 4 * expected) {
+      filter.clear(); //big enough, and not much too big, so keep the memory
+    } else {
+      filter = BloomFilter(expected);
+    }
+    for (const int *p = impl.begin(); p != impl.end(); ++p) {
+      filter.insert(*p);
+    }
+    stale = 0;
+  }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+template <typename Impl>
+class IntSetAdapter : public IntSet {
+  // OVERVIEW: run-time IntSet interface to a StaticIntSet implementation, for
+  //           callers that choose the implementation while the program runs
+ public:
+
+  virtual void insert(int v) { impl.insert(v); }
+  virtual void remove(int v) { impl.remove(v); }
+  virtual bool query(int v) const { return impl.query(v); }
+  virtual int size() const { return impl.size(); }
+  virtual void print() const { impl.print(); }
+
+  //EFFECTS: returns the wrapped implementation
+  Impl & get() { return impl; }
+
+ private:
+  Impl impl;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Generic algorithms, written once against the compile-time interface
+
+//EFFECTS: returns the number of keys[0], ..., keys[n-1] that are in s
+template <typename Derived>
+int count_members(const StaticIntSet<Derived> &s, const int keys[], int n) {
+  int count = 0;
+  for (int i = 0; i < n; ++i) {
+    if (s.query(keys[i])) ++count;
+  }
+  return count;
+}
+
+//REQUIRES: s has room for the keys that are not already in it
+//MODIFIES: s
+//EFFECTS: inserts keys[0], ..., keys[n-1] into s
+template <typename Derived>
+void insert_all(StaticIntSet<Derived> &s, const int keys[], int n) {
+  for (int i = 0; i < n; ++i) {
+    s.insert(keys[i]);
+  }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // IntSet factory function
 
 // Dirty global variable trick.  We'll fix this when we learn about dynamic
 //  memory.
-static IntSetSorted g_iss;
-static IntSetUnsorted g_isu;
+static IntSetAdapter<IntSetSorted> g_iss;
+static IntSetAdapter<IntSetUnsorted> g_isu;
 
 //EFFECTS: returns a pointer to an IntSet
 IntSet * IntSet_factory() {
@@ -311,6 +623,96 @@ IntSet * IntSet_factory() {
 
 
 ////////////////////////////////////////////////////////////////////////////////
+#ifdef INTSET_BENCHMARK
+// A small set, far below the filter's initial capacity, with constant
+// insert/remove churn.  Removed keys must not pile up in the filter, so
+// queries for random non-members stay mostly filtered.
+void check_bloom_churn() {
+  const int KEYS = 200, MEMBERS = 20, ROUNDS = 100000;
+  std::mt19937 rng(29);
+  std::uniform_int_distribution<int> any_key(0, KEYS - 1);
+  BloomIntSet<IntSetSorted> set;
+  vector<char> present(KEYS, 0);
+  for (int k = 0; k < MEMBERS; ++k) {
+    set.insert(k);
+    present[k] = 1;
+  }
+  for (int r = 0; r < ROUNDS; ++r) {
+    int victim = any_key(rng);
+    while (!present[victim]) victim = (victim + 1) % KEYS;
+    int fresh = any_key(rng);
+    while (present[fresh]) fresh = (fresh + 1) % KEYS;
+    set.remove(victim);
+    present[victim] = 0;
+    set.insert(fresh);
+    present[fresh] = 1;
+    for (int q = 0; q < 10; ++q) {
+      int k = any_key(rng);
+      bench_check(set.query(k) == (present[k] != 0), "BloomIntSet: query");
+    }
+  }
+  BenchmarkRow().add("impl", "14_BloomIntSet<IntSetSorted>")
+                .add("mix", "small_churn")
+                .add("size", MEMBERS)
+                .add("false_positive_rate", set.false_positive_rate())
+                .print(cout);
+  bench_check(set.false_positive_rate() < 0.015,
+              "BloomIntSet: false positive rate under churn");
+}
+
+int main(int argc, char *argv[]) {
+  check_bloom_churn();
+
+  int capacity = IntSet::ELTS_CAPACITY;
+  vector<int> sizes;
+  sizes.push_back(10);
+  sizes.push_back(capacity);
+  vector<IntSetWorkload> workloads =
+    IntSet_workloads(argc, argv, sizes, capacity);
+
+  // each implementation runs twice: through IntSet &, where every
+  // operation is a virtual call like for a caller of IntSet_factory(), and
+  // on the concrete type, where calls are resolved at compile time
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    IntSetAdapter<IntSetSorted> iss;
+    IntSetAdapter<IntSetUnsorted> isu;
+    IntSet &sorted = iss;
+    IntSet &unsorted = isu;
+    benchmark_IntSet(cout, "14_IntSetSorted/virtual", sorted, workloads[i]);
+    benchmark_IntSet(cout, "14_IntSetSorted/static", iss.get(), workloads[i]);
+    benchmark_IntSet(cout, "14_IntSetUnsorted/virtual", unsorted, workloads[i]);
+    benchmark_IntSet(cout, "14_IntSetUnsorted/static", isu.get(), workloads[i]);
+
+    BloomIntSet<IntSetSorted> bss;
+    BloomIntSet<IntSetUnsorted> bsu;
+    benchmark_IntSet(cout, "14_BloomIntSet<IntSetSorted>", bss, workloads[i]);
+    BenchmarkRow().add("impl", "14_BloomIntSet<IntSetSorted>")
+                  .add("false_positive_rate", bss.false_positive_rate())
+                  .print(cout);
+    benchmark_IntSet(cout, "14_BloomIntSet<IntSetUnsorted>", bsu, workloads[i]);
+    BenchmarkRow().add("impl", "14_BloomIntSet<IntSetUnsorted>")
+                  .add("false_positive_rate", bsu.false_positive_rate())
+                  .print(cout);
+  }
+
+  // tight query loops, where the call overhead is most of the cost
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    if (workloads[i].mix != READ_HEAVY) continue;
+    IntSetAdapter<IntSetSorted> iss;
+    IntSetAdapter<IntSetUnsorted> isu;
+    IntSet &sorted = iss;
+    IntSet &unsorted = isu;
+    benchmark_IntSet_queries(cout, "14_IntSetSorted/virtual", sorted,
+                             workloads[i]);
+    benchmark_IntSet_queries(cout, "14_IntSetSorted/static", iss.get(),
+                             workloads[i]);
+    benchmark_IntSet_queries(cout, "14_IntSetUnsorted/virtual", unsorted,
+                             workloads[i]);
+    benchmark_IntSet_queries(cout, "14_IntSetUnsorted/static", isu.get(),
+                             workloads[i]);
+  }
+}
+#else
 int main () {
   IntSet *is = IntSet_factory();
   is->insert(7);
@@ -319,4 +721,49 @@ int main () {
   is->print();
   is->remove(7);
   is->print();
+
+  // order queries are only available on the sorted implementation
+  IntSetSorted iss;
+  for (int v = 10; v > 0; v -= 2) iss.insert(v);
+  iss.print();
+  cout << "rank(7) = " << iss.rank(7) << endl;
+  cout << "select(1) = " << iss.select(1) << endl;
+  cout << "count_range(3, 8) = " << iss.count_range(3, 8) << endl;
+
+  const int *first, *last;
+  iss.range(3, 8, first, last);
+  cout << "range(3, 8) = { ";
+  for (const int *p = first; p != last; ++p)
+    cout << *p << " ";
+  cout << "}" << endl;
+
+  // generic algorithms work on any StaticIntSet, with no virtual calls
+  const int keys[] = {1, 2, 3, 4, 5};
+  cout << "count_members = " << count_members(iss, keys, 5) << endl;
+  IntSetUnsorted isu;
+  insert_all(isu, keys, 5);
+  isu.print();
+
+  // a Bloom filter in front of the slow linear search answers most misses
+  BloomIntSet<IntSetUnsorted> bsu;
+  for (int v = 0; v < 50; ++v) bsu.insert(v);
+  int misses = 0;
+  for (int v = 100; v < 1100; ++v) misses += !bsu.query(v);
+  cout << "misses = " << misses
+       << ", false positive rate < 1%: " << (bsu.false_positive_rate() < 0.01)
+       << endl;
 }
+
+/* output
+{ 7 4 } 
+{ 4 } 
+{ 2 4 6 8 10 } 
+rank(7) = 3
+select(1) = 4
+count_range(3, 8) = 3
+range(3, 8) = { 4 6 8 }
+count_members = 2
+{ 1 2 3 4 5 } 
+misses = 1000, false positive rate < 1%: 1
+ */
+#endif
@@ -4,12 +4,19 @@
  * Dynamically sized and includes Big 3 (destructor, copy constructor and
  * overload assignment operator
  *
+ * To benchmark the IntSet instead of running the demo:
+ * $ g++ -std=c++11 -O2 -DNDEBUG -DINTSET_BENCHMARK 17_IntSet.cpp
+ *
  * by Andrew DeOrio <awdeorio@umich.edu>
  * 2013-11-07
  */
 
 #include <iostream> //cout, endl
 #include <cassert>  //assert
+#include "MemoryStats.h" //MemoryStats, memory_stats_print
+#ifdef INTSET_BENCHMARK
+#include "IntSet_Benchmark.h" //benchmark_IntSet
+#endif
 using namespace std;
 
 
@@ -62,12 +69,15 @@ private:
   //Default capacity of array
   static const int ELTS_CAPACITY_DEFAULT = 100;
 
-  //EFFECTS: returns the index of v if it exists in the set, ELTS_CAPACITY_DEFAULT otherwise
+  //EFFECTS: returns the index of v if it exists in the set, elts_capacity otherwise
   int indexOf(int v) const;
 
   //EFFECTS   enlarges the elts arrays, preserving contents
   //MODIFIES: this
   void grow();
+
+  //EFFECTS: returns the counters for the arrays of every IntSet
+  static MemoryStats & memory_stats();
 };
 
 
@@ -78,11 +88,14 @@ IntSet::IntSet(int capacity)
   : elts_size(0), elts_capacity(capacity) {
   assert(capacity > 0);
   elts = new int[capacity];
+  memory_stats().note_alloc(capacity * sizeof(int), capacity);
 }
 
 
 IntSet::IntSet(const IntSet &other) {
   elts = new int[other.elts_capacity];
+  memory_stats().note_alloc(other.elts_capacity * sizeof(int),
+                            other.elts_capacity);
   elts_size = other.elts_size;
   elts_capacity = other.elts_capacity;
 
@@ -95,9 +108,12 @@ IntSet::IntSet(const IntSet &other) {
 IntSet & IntSet::operator= (const IntSet &rhs) {
   if (this == &rhs) return *this; //check for self assignment
   delete[] elts; //remove all
+  memory_stats().note_free(elts_capacity * sizeof(int), elts_capacity);
 
   //initialize member variables
   elts = new int[rhs.elts_capacity];
+  memory_stats().note_alloc(rhs.elts_capacity * sizeof(int),
+                            rhs.elts_capacity);
   elts_size = rhs.elts_size;
   elts_capacity = rhs.elts_capacity;
 
@@ -110,6 +126,7 @@ IntSet & IntSet::operator= (const IntSet &rhs) {
 
 IntSet::~IntSet() {
   delete[] elts;
+  memory_stats().note_free(elts_capacity * sizeof(int), elts_capacity);
 }
 
 
@@ -122,7 +139,7 @@ void IntSet::insert(int v) {
 
 void IntSet::remove(int v) {
   int victim = indexOf(v);
-  if (victim == ELTS_CAPACITY_DEFAULT) return;//not found
+  if (victim == elts_capacity) return;//not found
   elts[victim] = elts[--elts_size];
 }
 
@@ -136,11 +153,11 @@ int IntSet::indexOf(int v) const {
   for (int i = 0; i < elts_size; ++i) {
     if (elts[i] == v) return i;
   }
-  return ELTS_CAPACITY_DEFAULT;
+  return elts_capacity;
 }
 
 bool IntSet::query(int v) const {
-  return (indexOf(v) != ELTS_CAPACITY_DEFAULT);
+  return (indexOf(v) != elts_capacity);
 }
 
 
@@ -153,16 +170,39 @@ void IntSet::print() const {
 
 void IntSet::grow() {
   int *tmp = new int[elts_capacity + 1];
+  memory_stats().note_alloc((elts_capacity + 1) * sizeof(int),
+                            elts_capacity + 1);
   for (int i = 0; i < elts_size; ++i) {
     tmp[i] = elts[i];
   }
   delete [] elts;
+  memory_stats().note_free(elts_capacity * sizeof(int), elts_capacity);
   elts = tmp;
   elts_capacity += 1;
 }
 
 
+MemoryStats & IntSet::memory_stats() {
+  static MemoryStats stats("IntSet", true); //IntSets on any thread
+  return stats;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
+#ifdef INTSET_BENCHMARK
+int main(int argc, char *argv[]) {
+  vector<int> sizes;
+  sizes.push_back(100);
+  sizes.push_back(1000);
+  vector<IntSetWorkload> workloads =
+    IntSet_workloads(argc, argv, sizes, 1 << 20);
+
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    IntSet is;
+    benchmark_IntSet(cout, "17_IntSet", is, workloads[i]);
+  }
+}
+#else
 int main () {
   IntSet is1(1);
   is1.insert(42);
@@ -173,4 +213,8 @@ int main () {
   is2.insert(43);
 
   is2.print();
+
+  // how much memory the two IntSets hold, and how often they allocated
+  memory_stats_print(cout);
 }
+#endif
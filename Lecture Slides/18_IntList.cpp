@@ -6,6 +6,7 @@
  * 2015-03-26 created
  */
 
+#include "ContainerTrace.h"
 #include <cassert>
 #include <iostream>
 using namespace std;
@@ -87,11 +88,12 @@ int & IntList::back() const {
 }
 
 void IntList::push_front(int datum) {
-  cout << "FIXME: push_front(): do something with 'back_ptr'\n";
   Node *p = new Node;
   p->datum = datum;
   p->next = front_ptr;
+  if (empty()) back_ptr = p;
   front_ptr = p;
+  trace_op(TRACE_PUSH_FRONT, this);
 }
 
 void IntList::push_back(int datum) {
@@ -105,14 +107,16 @@ void IntList::push_back(int datum) {
     back_ptr->next = p;
     back_ptr = p;
   }
+  trace_op(TRACE_PUSH_BACK, this);
 }
 
 void IntList::pop_front() {
-  cout << "FIXME: pop_front(): do something with 'back_ptr'\n";
   assert(!empty());
   Node *victim = front_ptr;
   front_ptr = front_ptr->next;
+  if (empty()) back_ptr = 0;
   delete victim; victim=0;
+  trace_op(TRACE_POP_FRONT, this);
 }
 
 void IntList::pop_all() {
@@ -122,6 +126,7 @@ void IntList::pop_all() {
 }
 
 void IntList::push_all(const IntList &other) {
+  trace_op(TRACE_COPY, this);
   for (Node *p=other.front_ptr; p != 0; p=p->next) {
     push_back(p->datum);
   }
@@ -171,22 +176,19 @@ int main() {
   l.pop_front();
   l.print();
   if (l.empty()) cout << "empty!\n";
+
+  // compile with -DCONTAINER_TRACE to see how many operations ran
+  trace_print(cout);
   return 0;
 }
 
 /* output
-FIXME: push_front(): do something with 'back_ptr'
 1 
-FIXME: push_front(): do something with 'back_ptr'
 2 1 
-FIXME: push_front(): do something with 'back_ptr'
 3 2 1 
 3
-FIXME: pop_front(): do something with 'back_ptr'
 2 1 
-FIXME: pop_front(): do something with 'back_ptr'
 1 
-FIXME: pop_front(): do something with 'back_ptr'
 
 empty!
 */
@@ -9,16 +9,25 @@
  */
 
 #include <cassert>  //assert
+#include <cstddef>  //size_t
+#include <functional> //less
 #include <iostream> //cout
+#include <memory>   //allocator, allocator_traits
+#include <new>      //placement new
+#include <type_traits> //is_nothrow_move_constructible
+#include <utility>  //move, forward
+#include "ContainerTrace.h" //trace_op
 // NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
 // namespace for every program that includes this file.
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // List declaration
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T> >
 class List {
-  //OVERVIEW: a singly-linked list
+  //OVERVIEW: a singly-linked list.  Nodes are allocated with Alloc, e.g.
+  //          PoolAllocator<T> from NodePool.h to recycle them from a pool,
+  //          or CountingAllocator<T> from MemoryStats.h to count them.
  public:
 
   //EFFECTS:  returns true if the list is empty
@@ -36,78 +45,272 @@ class List {
   //EFFECTS:  inserts datum into the front of the list
   void push_front(const T &datum);
 
+  //MODIFIES: this, datum
+  //EFFECTS:  moves datum into the front of the list
+  void push_front(T &&datum);
+
   //MODIFIES: this
   //EFFECTS:  inserts datum into the back of the list
   void push_back(const T &datum);
 
+  //MODIFIES: this, datum
+  //EFFECTS:  moves datum into the back of the list
+  void push_back(T &&datum);
+
+  //MODIFIES: this
+  //EFFECTS:  inserts an element constructed in place from args into the
+  //          front of the list, e.g. emplace_front("Colo") for a Gorilla
+  template <typename... Args>
+  void emplace_front(Args&&... args);
+
+  //MODIFIES: this
+  //EFFECTS:  inserts an element constructed in place from args into the
+  //          back of the list
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+
   //REQUIRES: list is not empty
   //MODIFIES: this
   //EFFECTS:  removes the item at the front of the list
   void pop_front();
 
+  //REQUIRES: other is not this, and its allocator compares equal to ours
+  //MODIFIES: this, other
+  //EFFECTS:  moves all elements of other to the back of this in O(1) time,
+  //          without copying or allocating, leaving other empty
+  void append(List &&other);
+
+  //REQUIRES: less is a strict weak ordering of T
+  //MODIFIES: this
+  //EFFECTS:  sorts the list so that less(b, a) is false for every element
+  //          a before b.  Equal elements keep their order.  Only the links
+  //          change: no element is copied, and no memory is allocated.
+  template <typename Compare>
+  void sort(Compare less);
+
+  //MODIFIES: this
+  //EFFECTS:  sorts the list with operator<
+  void sort();
+
+  //REQUIRES: this and other are sorted by less, other is not this, and
+  //          other's allocator compares equal to ours
+  //MODIFIES: this, other
+  //EFFECTS:  moves the elements of other into this, keeping this sorted and
+  //          leaving other empty.  On ties, elements of this come first.
+  template <typename Compare>
+  void merge(List &&other, Compare less);
+
+  //MODIFIES: this, other
+  //EFFECTS:  merges with operator<
+  void merge(List &&other);
+
+  //MODIFIES: this
+  //EFFECTS:  removes every element that is equal to the one before it, so a
+  //          sorted list is left with no duplicates
+  void unique();
+
+  //MODIFIES: this
+  //EFFECTS:  moves all elements into one new allocation, in list order, so
+  //          that traversal reads memory sequentially.  Iterators and
+  //          pointers to elements are invalidated.
+  void compact();
+
+  //MODIFIES: this
+  //EFFECTS:  a step of compact() that takes O(max_nodes) time.  Picks up
+  //          where the last step stopped, passes over elements already
+  //          stored right after the one before them, and moves the others
+  //          into one new allocation, max_nodes elements in all.  Returns
+  //          that number, 0 once the list is compact.  Iterators and
+  //          pointers to moved elements are invalidated.
+  std::size_t compact(std::size_t max_nodes);
+
   //EFFECTS: prints the list to stdout
   void print() const;
 
   //default constructor and Big Three
   List();
   List(const List &other);
+
+  //EFFECTS: creates an empty list that allocates its nodes with alloc_in
+  explicit List(const Alloc &alloc_in);
+
+  //MODIFIES: other
+  //EFFECTS:  move constructor takes the nodes of other, leaving it empty
+  List(List &&other);
+
+  //MODIFIES: this, rhs
+  //EFFECTS:  move assignment takes the nodes of rhs, leaving it empty
+  List & operator=(List &&rhs);
+
   ~List();
   List & operator=(const List &rhs);
 
 private:
   //a private type
+  struct NodeBlock;
   struct Node {
+    //EFFECTS: constructs datum from args, without a copy
+    template <typename... Args>
+    Node(Node *next_in, Args&&... args)
+      : next(next_in), block(0), datum(std::forward<Args>(args)...) {}
+
     Node *next;
+    NodeBlock *block; //shared allocation this Node lives in, 0 if its own
     T datum;
   };
 
+  //Header of one allocation holding many Nodes, made by a copy.  It sits in
+  //the first Node-sized slot and the Nodes follow it.  Nodes may be spliced
+  //into other lists, so the block is released when its last Node is
+  //destroyed, wherever that is.
+  struct NodeBlock {
+    std::size_t capacity; //number of Node slots after the header
+    std::size_t live;     //Nodes not yet destroyed
+  };
+
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node>
+    NodeAlloc;
+
+  //true_type if relocate() moves elements, which it does if that can't
+  //throw, or if T can't be copied, as std::move_if_noexcept() does
+  typedef std::integral_constant<bool,
+    std::is_nothrow_move_constructible<T>::value ||
+    !std::is_copy_constructible<T>::value> RelocateByMove;
+
+  //EFFECTS: returns a new Node linked to next, with datum constructed
+  //         from args
+  template <typename... Args>
+  Node * create_node(Node *next, Args&&... args);
+
+  //EFFECTS: destroys the Node at p and releases its memory
+  void destroy_node(Node *p);
+
   //MODIFIES: this
-  //EFFECTS:  copies all nodes from l to this
+  //EFFECTS:  copies all nodes from other to the back of this, with one
+  //          allocation for all of them
   void push_all(const List &other);
 
   //MODIFIES: this
   //EFFECTS:  removes all nodes
   void pop_all();
 
+  //REQUIRES: at least n > 0 nodes follow pred, or the list has at least n
+  //          nodes if pred is 0
+  //MODIFIES: this
+  //EFFECTS:  moves the n elements after pred, or at the front if pred is 0,
+  //          into new Nodes in one allocation, in the same order.  Returns
+  //          the last new Node.
+  Node * relocate(Node *pred, std::size_t n);
+
+  //REQUIRES: n nodes start at old, and block has n empty slots
+  //MODIFIES: this, block, old
+  //EFFECTS:  moves the n elements from old on into the slots of block,
+  //          destroying each old node as soon as its element is moved, and
+  //          leaves old at the node after them.  If a move throws, the
+  //          moved elements stay in block, and old is the node whose
+  //          element threw.
+  void fill_block(NodeBlock *block, std::size_t n, Node *&old,
+                  std::true_type);
+
+  //EFFECTS:  like the above, but copies the elements, and destroys the old
+  //          nodes only once all of them are copied.  If a copy throws,
+  //          block is left empty and the old nodes are untouched.
+  void fill_block(NodeBlock *block, std::size_t n, Node *&old,
+                  std::false_type);
+
+  //REQUIRES: a and b are 0-terminated chains sorted by less
+  //EFFECTS:  links the nodes of a and b into one sorted chain, taking from a
+  //          on ties, and returns its first node
+  template <typename Compare>
+  static Node * merge_chains(Node *a, Node *b, Compare less);
+
   Node *front_ptr; //pointer to the first Node in the list, 0 for empty list
   Node *back_ptr;  //pointer to the last Node in the list, 0 for empty list
+  Node *compact_back; //end of the front nodes compact() found in place, or
+                      //0.  Operations that relink them reset it to 0.
+  NodeAlloc node_alloc; //source of Node memory
 };
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // List implementation
 
-template <typename T>
-bool List<T>::empty() const {
+template <typename T, typename Alloc>
+bool List<T, Alloc>::empty() const {
   return front_ptr == 0;
 }
 
-template <typename T>
-T & List<T>::front() const {
+template <typename T, typename Alloc>
+T & List<T, Alloc>::front() const {
   assert(!empty());
   return front_ptr->datum;
 }
 
-template <typename T>
-T & List<T>::back() const {
+template <typename T, typename Alloc>
+T & List<T, Alloc>::back() const {
   assert(!empty());
   return back_ptr->datum;
 }
 
-template <typename T>
-void List<T>::push_front(const T &datum) {
-  std::cout << "FIXME: push_front(): do something with 'back_ptr'\n";
-  Node *p = new Node;
-  p->datum = datum;
-  p->next = front_ptr;
+template <typename T, typename Alloc>
+template <typename... Args>
+typename List<T, Alloc>::Node *
+List<T, Alloc>::create_node(Node *next, Args&&... args) {
+  Node *p = node_alloc.allocate(1);
+  try {
+    new (p) Node(next, std::forward<Args>(args)...);
+  } catch (...) {
+    node_alloc.deallocate(p, 1);
+    throw;
+  }
+  return p;
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::destroy_node(Node *p) {
+  NodeBlock *block = p->block;
+  p->~Node();
+  if (!block) {
+    node_alloc.deallocate(p, 1);
+  } else if (--block->live == 0) {
+    node_alloc.deallocate(reinterpret_cast<Node *>(block), block->capacity+1);
+  }
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::push_front(const T &datum) {
+  emplace_front(datum);
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::push_front(T &&datum) {
+  emplace_front(std::move(datum));
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+void List<T, Alloc>::emplace_front(Args&&... args) {
+  Node *p = create_node(front_ptr, std::forward<Args>(args)...);
+  if (empty()) back_ptr = p;
   front_ptr = p;
+  compact_back = 0;
+  trace_op(TRACE_PUSH_FRONT, this);
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::push_back(const T &datum) {
+  emplace_back(datum);
 }
 
-template <typename T>
-void List<T>::push_back(const T &datum) {
-  Node *p = new Node;
-  p->datum = datum;
-  p->next = 0;
+template <typename T, typename Alloc>
+void List<T, Alloc>::push_back(T &&datum) {
+  emplace_back(std::move(datum));
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+void List<T, Alloc>::emplace_back(Args&&... args) {
+  Node *p = create_node(0, std::forward<Args>(args)...);
   if (empty()) {
     front_ptr = back_ptr = p;
   } else {
@@ -115,56 +318,337 @@ void List<T>::push_back(const T &datum) {
     back_ptr->next = p;
     back_ptr = p;
   }
+  trace_op(TRACE_PUSH_BACK, this);
 }
 
-template <typename T>
-void List<T>::pop_front() {
-  std::cout << "FIXME: pop_front(): do something with 'back_ptr'\n";
+template <typename T, typename Alloc>
+void List<T, Alloc>::pop_front() {
   assert(!empty());
   Node *victim = front_ptr;
   front_ptr = front_ptr->next;
-  delete victim; victim=0;
+  if (empty()) back_ptr = 0;
+  if (victim == compact_back) compact_back = 0;
+  destroy_node(victim); victim=0;
+  trace_op(TRACE_POP_FRONT, this);
 }
 
-template <typename T>
-void List<T>::pop_all() {
+template <typename T, typename Alloc>
+void List<T, Alloc>::pop_all() {
   while (!empty()) {
     pop_front();
   }
 }
 
-template <typename T>
-void List<T>::push_all(const List &other) {
-  for (Node *p=other.front_ptr; p!=0; p=p->next) {
-    push_back(p->datum);
+template <typename T, typename Alloc>
+void List<T, Alloc>::append(List &&other) {
+  assert(&other != this);
+  assert(node_alloc == other.node_alloc);
+  if (other.empty()) return;
+  if (empty()) {
+    front_ptr = other.front_ptr;
+  } else {
+    back_ptr->next = other.front_ptr;
+  }
+  back_ptr = other.back_ptr;
+  other.front_ptr = other.back_ptr = other.compact_back = 0;
+  trace_op(TRACE_SPLICE, this);
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+typename List<T, Alloc>::Node *
+List<T, Alloc>::merge_chains(Node *a, Node *b, Compare less) {
+  Node *first = 0;
+  Node **link = &first; //where the next node goes
+  Node *last = 0;
+  while (a && b) {
+    if (less(b->datum, a->datum)) {
+      last = b;
+      b = b->next;
+    } else {
+      last = a;
+      a = a->next;
+    }
+    *link = last;
+    link = &last->next;
   }
+  *link = a ? a : b;
+  return first;
 }
 
-template <typename T>
-List<T>::List()
-  : front_ptr(0), back_ptr(0) {}
+// Bottom-up merge sort that works like a binary counter.  bins[i] is empty
+// or holds a sorted run of 2^i nodes.  Each node taken off the list is a
+// run of one, carried up through the full bins like a carry bit.  Runs are
+// merged soon after their nodes were last touched, so this stays in cache
+// far better than merging the whole list once per pass.  Bins with higher
+// numbers hold earlier nodes, which is what keeps the sort stable.
+template <typename T, typename Alloc>
+template <typename Compare>
+void List<T, Alloc>::sort(Compare less) {
+  if (empty() || front_ptr == back_ptr) return;
+  const int MAX_BINS = 64; //enough for 2^64 nodes
+  Node *bins[MAX_BINS];
+  int used = 0;
+  Node *rest = front_ptr;
+  while (rest) {
+    Node *carry = rest;
+    rest = rest->next;
+    carry->next = 0;
+    int i = 0;
+    for (; i < used && bins[i]; ++i) {
+      carry = merge_chains(bins[i], carry, less);
+      bins[i] = 0;
+    }
+    if (i == used) ++used;
+    bins[i] = carry;
+  }
+
+  compact_back = 0;
+  Node *sorted = 0;
+  for (int i = 0; i < used; ++i) {
+    if (bins[i]) sorted = sorted ? merge_chains(bins[i], sorted, less) : bins[i];
+  }
+  front_ptr = sorted;
+  back_ptr = sorted;
+  while (back_ptr->next) back_ptr = back_ptr->next;
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::sort() {
+  sort(std::less<T>());
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void List<T, Alloc>::merge(List &&other, Compare less) {
+  assert(&other != this);
+  assert(node_alloc == other.node_alloc);
+  if (other.empty()) return;
+  // other's last element goes last unless it sorts before ours
+  if (empty() || !less(other.back_ptr->datum, back_ptr->datum)) {
+    back_ptr = other.back_ptr;
+  }
+  front_ptr = merge_chains(front_ptr, other.front_ptr, less);
+  other.front_ptr = other.back_ptr = 0;
+  compact_back = other.compact_back = 0;
+  trace_op(TRACE_SPLICE, this);
+}
 
-template <typename T>
-List<T>::~List() {
+template <typename T, typename Alloc>
+void List<T, Alloc>::merge(List &&other) {
+  merge(std::move(other), std::less<T>());
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::unique() {
+  if (empty()) return;
+  compact_back = 0;
+  Node *p = front_ptr;
+  while (p->next) {
+    if (p->next->datum == p->datum) {
+      Node *victim = p->next;
+      p->next = victim->next;
+      destroy_node(victim); victim=0;
+      trace_op(TRACE_ERASE, this);
+    } else {
+      p = p->next;
+    }
+  }
+  back_ptr = p;
+}
+
+template <typename T, typename Alloc>
+typename List<T, Alloc>::Node *
+List<T, Alloc>::relocate(Node *pred, std::size_t n) {
+  static_assert(sizeof(NodeBlock) <= sizeof(Node), "header must fit a slot");
+  assert(n > 0);
+  Node *first = pred ? pred->next : front_ptr;
+  Node *raw = node_alloc.allocate(n + 1);
+  NodeBlock *block = new (static_cast<void *>(raw)) NodeBlock;
+  block->capacity = n;
+  block->live = 0;
+  Node *old = first;
+  try {
+    fill_block(block, n, old, RelocateByMove());
+  } catch (...) {
+    if (block->live == 0) {
+      node_alloc.deallocate(raw, n + 1);
+      throw;
+    }
+    // A move threw after others were done, and their old nodes are gone.
+    // Link the ones in block, so that the list keeps every element.
+    compact_back = 0;
+    raw[block->live].next = old;
+    if (pred) {
+      pred->next = raw + 1;
+    } else {
+      front_ptr = raw + 1;
+    }
+    throw;
+  }
+
+  Node *last = raw + n;
+  last->next = old; //the node after the moved ones
+  if (pred) {
+    pred->next = raw + 1;
+  } else {
+    front_ptr = raw + 1;
+  }
+  if (!old) back_ptr = last;
+  return last;
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::fill_block(NodeBlock *block, std::size_t n, Node *&old,
+                                std::true_type) {
+  // each old node goes as soon as it is moved, in the same pass over the
+  // scattered nodes
+  Node *slot = reinterpret_cast<Node *>(block) + 1;
+  for (; block->live < n; ++block->live, ++slot) {
+    new (slot) Node(slot + 1, std::move(old->datum));
+    slot->block = block;
+    Node *victim = old;
+    old = old->next;
+    destroy_node(victim); victim=0;
+  }
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::fill_block(NodeBlock *block, std::size_t n, Node *&old,
+                                std::false_type) {
+  // copy, so that a failure leaves the list as it was
+  Node *first = reinterpret_cast<Node *>(block) + 1;
+  Node *slot = first;
+  Node *p = old;
+  try {
+    for (; block->live < n; ++block->live, ++slot, p = p->next) {
+      new (slot) Node(slot + 1, static_cast<const T &>(p->datum));
+      slot->block = block;
+    }
+  } catch (...) {
+    while (slot != first) (--slot)->~Node();
+    block->live = 0;
+    throw;
+  }
+  while (old != p) {
+    Node *victim = old;
+    old = old->next;
+    destroy_node(victim); victim=0;
+  }
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::compact() {
+  std::size_t n = 0;
+  for (Node *p=front_ptr; p!=0; p=p->next) ++n;
+  compact_back = n > 0 ? relocate(0, n) : 0;
+}
+
+template <typename T, typename Alloc>
+std::size_t List<T, Alloc>::compact(std::size_t max_nodes) {
+  // Pass over nodes already in place: in a block, and either right after
+  // the node before them, or first in their block when the node before
+  // them is last in its own.  Nodes that alternate between blocks are not
+  // in place, and get moved.
+  Node *pred = compact_back;
+  Node *p = pred ? pred->next : front_ptr;
+  std::size_t done = 0;
+  while (done < max_nodes && p && p->block &&
+         (!pred || p == pred + 1 ||
+          (pred == reinterpret_cast<Node *>(pred->block) + pred->block->capacity
+           && p == reinterpret_cast<Node *>(p->block) + 1))) {
+    pred = p;
+    p = p->next;
+    ++done;
+  }
+  std::size_t n = 0;
+  for (Node *q=p; q!=0 && done+n<max_nodes; q=q->next) ++n;
+  if (n > 0) pred = relocate(pred, n);
+  compact_back = pred;
+  return done + n;
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::push_all(const List &other) {
+  static_assert(sizeof(NodeBlock) <= sizeof(Node), "header must fit a slot");
+  trace_op(TRACE_COPY, this);
+  std::size_t n = 0;
+  for (Node *p=other.front_ptr; p!=0; p=p->next) ++n;
+  if (n == 0) return;
+
+  Node *raw = node_alloc.allocate(n + 1);
+  NodeBlock *block = new (static_cast<void *>(raw)) NodeBlock;
+  block->capacity = n;
+  block->live = 0;
+  try {
+    Node *slot = raw + 1;
+    for (Node *p=other.front_ptr; p!=0; p=p->next, ++slot) {
+      new (slot) Node(0, p->datum);
+      slot->block = block;
+      ++block->live;
+      if (empty()) {
+        front_ptr = slot;
+      } else {
+        back_ptr->next = slot;
+      }
+      back_ptr = slot;
+    }
+  } catch (...) {
+    // Nodes already linked keep the block alive, and go with this list
+    if (block->live == 0) node_alloc.deallocate(raw, n + 1);
+    throw;
+  }
+}
+
+template <typename T, typename Alloc>
+List<T, Alloc>::List()
+  : front_ptr(0), back_ptr(0), compact_back(0) {}
+
+template <typename T, typename Alloc>
+List<T, Alloc>::List(const Alloc &alloc_in)
+  : front_ptr(0), back_ptr(0), compact_back(0), node_alloc(alloc_in) {}
+
+template <typename T, typename Alloc>
+List<T, Alloc>::~List() {
   pop_all();
 }
 
-template <typename T>
-List<T>::List(const List &other)
-  : front_ptr(0), back_ptr(0) {
+template <typename T, typename Alloc>
+List<T, Alloc>::List(const List &other)
+  : front_ptr(0), back_ptr(0), compact_back(0), node_alloc(other.node_alloc) {
   push_all(other);
 }
 
-template <typename T>
-List<T> & List<T>::operator= (const List &rhs) {
+template <typename T, typename Alloc>
+List<T, Alloc> & List<T, Alloc>::operator= (const List &rhs) {
   if (this == &rhs) return *this;
   pop_all();
   push_all(rhs);
   return *this;
 }
 
-template <typename T>
-void List<T>::print() const {
+template <typename T, typename Alloc>
+List<T, Alloc>::List(List &&other)
+  : front_ptr(other.front_ptr), back_ptr(other.back_ptr),
+    compact_back(other.compact_back), node_alloc(other.node_alloc) {
+  other.front_ptr = other.back_ptr = other.compact_back = 0;
+}
+
+template <typename T, typename Alloc>
+List<T, Alloc> & List<T, Alloc>::operator= (List &&rhs) {
+  if (this == &rhs) return *this;
+  pop_all();
+  // the nodes must later go back to the allocator they came from
+  node_alloc = rhs.node_alloc;
+  front_ptr = rhs.front_ptr;
+  back_ptr = rhs.back_ptr;
+  compact_back = rhs.compact_back;
+  rhs.front_ptr = rhs.back_ptr = rhs.compact_back = 0;
+  return *this;
+}
+
+template <typename T, typename Alloc>
+void List<T, Alloc>::print() const {
   for (Node *i=front_ptr; i != 0; i=i->next) {
     std::cout << i->datum << " ";
   }
@@ -7,12 +7,16 @@
  */
 
 #include "19_List.h"
+#include "IntrusiveList.h"
+#include "ImmutableList.h"
 #include <iostream>
 #include <string>
+#include <utility>
 using namespace std;
 
 
-class Gorilla {
+// ListHook lets a Gorilla be linked into an IntrusiveList
+class Gorilla : public ListHook {
   string name;
 public:
   Gorilla() : name("noname") { cout << "Gorilla default ctor\n"; }
@@ -21,11 +25,16 @@ public:
     cout << "Gorilla ctor: " << name << "\n";
   }
 
-  Gorilla(const Gorilla &other) {
+  Gorilla(const Gorilla &other) : ListHook() {
     name = other.name + " clone";
     cout << "Gorilla copy ctor: " << name << "\n";
   }
 
+  Gorilla(Gorilla &&other) : ListHook(), name(std::move(other.name)) {
+    other.name = "moved-from";
+    cout << "Gorilla move ctor: " << name << "\n";
+  }
+
   ~Gorilla() {
     cout << "Gorilla dtor: " << name << "\n";
   }
@@ -50,6 +59,14 @@ int main() {
   zoo.push_front(Gorilla("Colo"));
 }
 
+{
+  cout << "\n*** Constructing in place ***\n";
+  List <Gorilla> zoo;
+  zoo.emplace_front("Koko");  //no temporary, no copies
+  Gorilla g("Bongo");
+  zoo.push_back(std::move(g));  //moves the name instead of copying it
+}
+
 {
   cout << "\n*** Container of pointers ***\n";
 
@@ -60,8 +77,15 @@ int main() {
   zoo.push_front(new Gorilla("Colo"));
   zoo.push_front(new Gorilla("Koko"));
 
+  // one day Bongo arrived from another zoo.  append() moves him over
+  // without copying the list.
+  List<Gorilla*> arrivals;
+  arrivals.push_front(new Gorilla("Bongo"));
+  zoo.append(std::move(arrivals));
+
   // Francine the zoo keeper fed the animals each day.  In the morning she
-  // made a list of all the animals
+  // made a list of all the animals.  The copy takes one allocation for all
+  // of its nodes.
   List<Gorilla*> todo = zoo;
 
   // She said hello to each animal, fed it, and removed it from her todo list
@@ -79,5 +103,48 @@ int main() {
 
 }
 
+{
+  cout << "\n*** Intrusive container ***\n";
+
+  // This zoo links the Gorillas themselves instead of allocating a Node for
+  // each one.  With DeleteDisposer it owns them, and deletes the ones still
+  // there when it closes.
+  IntrusiveList<Gorilla, DeleteDisposer> zoo;
+  Gorilla *koko = new Gorilla("Koko");
+  zoo.push_back(*new Gorilla("Colo"));
+  zoo.push_back(*koko);
+  zoo.push_back(*new Gorilla("Bongo"));
+
+  // Koko moves to another zoo, and takes itself off the list in O(1) time
+  koko->unlink();
+  delete koko;
+
+  for (IntrusiveList<Gorilla, DeleteDisposer>::Iterator i = zoo.begin();
+       i != zoo.end(); ++i) {
+    cout << "Hi, " << i->get_name() << "\n";
+  }
+}
+
+{
+  cout << "\n*** Persistent container ***\n";
+
+  // push_front() returns a new zoo that shares the old one's nodes
+  ImmutableList<Gorilla*> zoo;
+  zoo = zoo.push_front(new Gorilla("Colo"));
+  zoo = zoo.push_front(new Gorilla("Koko"));
+
+  // Francine's todo list is the same nodes as the zoo: nothing is copied
+  ImmutableList<Gorilla*> todo = zoo;
+  while (!todo.empty()) {
+    cout << "Hi, " << todo.front()->get_name() << "\n";
+    todo = todo.pop_front();  //the zoo still has everyone
+  }
+
+  while (!zoo.empty()) {
+    delete zoo.front();
+    zoo = zoo.pop_front();
+  }
+}
+
   return 0;
 }
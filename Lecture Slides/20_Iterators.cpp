@@ -5,13 +5,18 @@
  */
 
 #include "20_List_with_Iterator.h"
+#include "UnrolledList.h"
+#include "Duplicates.h"
 #include <iostream>
 using namespace std;
 
 
-bool no_duplicates(const List<int> &l) {
-  for (List<int>::Iterator i=l.begin(); i != l.end(); ++i) {
-    List<int>::Iterator j=i; ++j;
+//EFFECTS: returns true if no element of l appears twice.  Works with any
+//         container that has an Iterator, e.g. List<int> or UnrolledList<int>
+template <typename Container>
+bool no_duplicates(const Container &l) {
+  for (typename Container::ConstIterator i=l.begin(); i != l.end(); ++i) {
+    typename Container::ConstIterator j=i; ++j;
     for (; j != l.end(); ++j) {
       if (*i == *j) return false;
     }
@@ -36,6 +41,16 @@ int main() {
 
   cout << "no_duplicates(l) = " << no_duplicates(l) << endl;
 
+  // same algorithm over an unrolled list, which keeps up to 16 ints per node
+  UnrolledList<int> u;
+  for (int i = 0; i < 20; ++i) u.push_back(i % 18);
+  cout << "no_duplicates(u) = " << no_duplicates(u) << endl;
+
+  // no_duplicates() compares every pair, O(n^2).  first_duplicate() from
+  // Duplicates.h remembers what it has seen instead, O(n).
+  UnrolledList<int>::Iterator d = first_duplicate(u.begin(), u.end());
+  cout << "first duplicate in u = " << *d << endl;
+
   ////////////////////////////////////////
   //C++11 version
   //
@@ -8,40 +8,26 @@
  */
 
 #include "20_List_with_Iterator.h"
+#include "ListViews.h"
+#include "Predicates.h" //GreaterN, LessN, InRange
+#include "BatchPredicates.h"
+#include "RangeClassifier.h"
 #include <iostream>
 using namespace std;
 
 
-class GreaterN {
-  //OVERVIEW: functor returns true if input is greater than limit
-  int limit;
+class ToCelsius {
+  //OVERVIEW: functor converts a Fahrenheit temperature to Celsius
 public:
-  GreaterN(int limit_in) : limit(limit_in) {}
-  bool operator() (int n) { return n > limit; }
+  int operator() (int f) { return (f - 32) * 5 / 9; }
 };
 
-class LessN {
-  //OVERVIEW: functor returns true if input is less than limit
-  int limit;
-public:
-  LessN(int limit_in) : limit(limit_in) {}
-  bool operator() (int n) { return n < limit; }
-};
-
-class InRange {
-  //OVERVIEW: functor returns true if input is within a range
-  int min, max;
-public:
-  InRange(int min_in, int max_in)
-  : min(min_in), max(max_in) {}
-
-  bool operator() (int n) { return (min <= n) && (n <= max); }
-};
-
-//EFFECTS: returns true if pred() returns true for any of the elements in l
-template <class Predicate>
-bool any_of(const List<int> &l, Predicate pred) {
-  for(List<int>::Iterator i=l.begin(); i!=l.end(); ++i)
+//EFFECTS: returns true if pred() returns true for any of the elements in l.
+//         Works with any container that has an Iterator, e.g. List<int> or
+//         UnrolledList<int>
+template <class Container, class Predicate>
+bool any_of(const Container &l, Predicate pred) {
+  for(typename Container::ConstIterator i=l.begin(); i!=l.end(); ++i)
     if (pred(*i)) return true;
 
   return false;
@@ -64,4 +50,41 @@ int main() {
   cout << "is_solid " << is_solid(temp) << endl;
   cout << "is_liquid " << is_liquid(temp) << endl;
   cout << "is_gas " << is_gas(temp) << endl;
+
+  // combined functors: one test, (temp < 32) || (temp > 212) in one compare
+  cout << "(is_solid || is_gas) " << (is_solid || is_gas)(temp) << endl;
+  cout << "!is_liquid " << (!is_liquid)(temp) << endl;
+  cout << "any_of(l, is_solid || is_gas) = "
+       << any_of(l, is_solid || is_gas) << endl;
+
+  // a whole array at once, with vector instructions
+  int readings[] = {20, 96, 250, 150, 300, -5, 212, 32};
+  const int N = sizeof(readings) / sizeof(readings[0]);
+  cout << "batch_count_if(readings, is_solid || is_gas) = "
+       << batch_count_if(readings, N, is_solid || is_gas) << endl;
+
+  // all three phases in one pass, without a branch per reading
+  const int bounds[] = {32, 213}; //solid < 32 <= liquid < 213 <= gas
+  RangeClassifier phase(bounds, 2);
+  vector<size_t> counts = phase.histogram(readings, N);
+  cout << "solid " << counts[0] << " liquid " << counts[1]
+       << " gas " << counts[2] << endl;
+
+
+  // lazy views: nothing is copied, and the list is walked once
+  List<int> temps;
+  temps.push_back(20);
+  temps.push_back(96);
+  temps.push_back(250);
+  temps.push_back(150);
+  temps.push_back(300);
+  cout << "liquid temps in Celsius:";
+  for (int c : transform(filter(temps, is_liquid), ToCelsius()))
+    cout << " " << c;
+  cout << endl;
+  cout << "first gas: " << *take(filter(temps, is_gas), 1).begin() << endl;
+  cout << "any_of(gas temps, GreaterN(280)) = "
+       << any_of(filter(temps, is_gas), GreaterN(280)) << endl;
+  for (auto p : zip(temps, transform(temps, ToCelsius())))
+    cout << p.first << "F = " << p.second << "C" << endl;
 }
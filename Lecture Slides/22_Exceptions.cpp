@@ -1,36 +1,293 @@
 /* Exceptions.cpp
+ *
+ * To benchmark exceptions against error codes instead of running the demo:
+ * $ g++ -O2 -DNDEBUG -DEXCEPTIONS_BENCHMARK 22_Exceptions.cpp
  *
  * by Andrew DeOrio <awdeorio@umich.edu>
  * Created: 2013-12-02
  * Modified: 2015-04-09
  */
 
+#include <cassert>  //assert
+#include <climits>  //ULLONG_MAX
 #include <iostream>
+#include <string>
+#ifdef EXCEPTIONS_BENCHMARK
+#include "Benchmark.h" //now_ns, BenchmarkRow
+#include <random>
+#include <vector>
+#endif
 using namespace std;
 
 //Exception types
 class NegativeError {};
 class InputError {};
+class OverflowError {}; //the answer doesn't fit in the return type
+
+//Error codes, one per exception type, for the functions that don't throw
+enum ErrorCode {
+  ERROR_NONE,
+  ERROR_NEGATIVE,
+  ERROR_INPUT,
+  ERROR_OVERFLOW
+};
+
+template <typename T>
+class Result {
+  //OVERVIEW: the value of a computation, or the error that prevented it,
+  //          like std::expected in C++23.  Returning an error costs no more
+  //          than returning a value, while throwing and catching an
+  //          exception takes microseconds.
+ public:
+  Result(T value_in) : val(value_in), err(ERROR_NONE) {}
+  Result(ErrorCode err_in) : val(), err(err_in) {}
+
+  bool ok() const { return err == ERROR_NONE; }
+
+  //REQUIRES: ok()
+  T value() const {
+    assert(ok());
+    return val;
+  }
+
+  ErrorCode error() const { return err; }
+
+ private:
+  T val;
+  ErrorCode err;
+};
+
+//REQUIRES: err is not ERROR_NONE
+//EFFECTS:  throws the exception that matches err
+[[noreturn]] void throw_error(ErrorCode err) {
+  switch (err) {
+  case ERROR_NEGATIVE: throw NegativeError();
+  case ERROR_OVERFLOW: throw OverflowError();
+  default: throw InputError();
+  }
+}
+
+//EFFECTS: returns the value of r, or throws the exception for its error
+template <typename T>
+T value_or_throw(const Result<T> &r) {
+  if (!r.ok()) throw_error(r.error());
+  return r.value();
+}
+
+// unsigned __int128 is a g++ extension; __extension__ keeps -pedantic quiet
+__extension__ typedef unsigned __int128 uint128;
 
-//REQUIRES: n >= 0
-//EFFECTS: returns n!
-int factorial (int n) {
-  if (n<0) throw NegativeError();
-  int result = 1;
-  while (n > 0) {
-    result *= n;
-    n -= 1;
+// n! for every n whose factorial fits in T, computed by the compiler
+template <typename T, int N>
+struct FactorialTable {
+  T values[N]; //values[n] = n!
+  constexpr FactorialTable() : values() {
+    values[0] = 1;
+    for (int n = 1; n < N; ++n) values[n] = values[n - 1] * n;
+  }
+};
+
+const int FACTORIAL_MAX_64 = 20;  //largest n with n! < 2^64
+const int FACTORIAL_MAX_128 = 34; //largest n with n! < 2^128
+constexpr FactorialTable<unsigned long long, FACTORIAL_MAX_64 + 1>
+  FACTORIAL_64;
+constexpr FactorialTable<uint128, FACTORIAL_MAX_128 + 1> FACTORIAL_128;
+static_assert(FACTORIAL_64.values[FACTORIAL_MAX_64] >
+              ULLONG_MAX / (FACTORIAL_MAX_64 + 1), "21! fits in 64 bits");
+static_assert(FACTORIAL_128.values[FACTORIAL_MAX_128] >
+              ~uint128(0) / (FACTORIAL_MAX_128 + 1), "35! fits in 128 bits");
+
+//EFFECTS: returns n!, or ERROR_NEGATIVE if n < 0 and ERROR_OVERFLOW if
+//         n! doesn't fit in 64 bits
+Result<unsigned long long> try_factorial(int n) {
+  if (n<0) return ERROR_NEGATIVE;
+  if (n > FACTORIAL_MAX_64) return ERROR_OVERFLOW;
+  return FACTORIAL_64.values[n];
+}
+
+//EFFECTS: returns n!, throws NegativeError if n < 0 and OverflowError if
+//         n! doesn't fit in 64 bits
+unsigned long long factorial (int n) {
+  return value_or_throw(try_factorial(n));
+}
+
+//EFFECTS: returns n!, or ERROR_NEGATIVE if n < 0 and ERROR_OVERFLOW if
+//         n! doesn't fit in 128 bits
+Result<uint128> try_factorial128(int n) {
+  if (n<0) return ERROR_NEGATIVE;
+  if (n > FACTORIAL_MAX_128) return ERROR_OVERFLOW;
+  return FACTORIAL_128.values[n];
+}
+
+//EFFECTS: returns n!, throws NegativeError if n < 0 and OverflowError if
+//         n! doesn't fit in 128 bits
+uint128 factorial128 (int n) {
+  return value_or_throw(try_factorial128(n));
+}
+
+//EFFECTS: returns the greatest common divisor of a and b
+unsigned long long greatest_common_divisor(unsigned long long a,
+                                           unsigned long long b) {
+  while (b != 0) {
+    unsigned long long r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+//EFFECTS: returns n choose k, or ERROR_NEGATIVE for negative input or
+//         k > n, and ERROR_OVERFLOW if the answer doesn't fit in 64 bits
+Result<unsigned long long> try_combination(int n, int k) {
+  if (n < 0 || k < 0 || k > n) return ERROR_NEGATIVE;
+
+  // The factorials fit in 128 bits, and k! (n-k)! <= n!, so nothing can
+  // overflow.  C(34, 17) is well below 2^64.
+  if (n <= FACTORIAL_MAX_128) {
+    return static_cast<unsigned long long>(
+      FACTORIAL_128.values[n] /
+      (FACTORIAL_128.values[k] * FACTORIAL_128.values[n-k]));
+  }
+
+  // After step i, result = C(n-k+i, i), which only grows up to the answer,
+  // so if a step overflows, so would the answer.  Dividing by the gcd
+  // first means the product is never bigger than the next result.
+  if (k > n - k) k = n - k;
+  unsigned long long result = 1;
+  for (int i = 1; i <= k; ++i) {
+    unsigned long long g = greatest_common_divisor(result, i);
+    unsigned long long divisor = i / g;
+    unsigned long long factor = (n - k + i) / divisor; //divides exactly
+    result /= g;
+    if (result > ULLONG_MAX / factor) return ERROR_OVERFLOW;
+    result *= factor;
   }
   return result;
 }
 
-//EFFECTS: returns n choose k, throws an exception for negative input
-int combination(int n, int k) {
-  return factorial(n) / (factorial(k) * factorial(n-k));
+//EFFECTS: returns n choose k, throws NegativeError for negative input or
+//         k > n, and OverflowError if the answer doesn't fit in 64 bits
+unsigned long long combination(int n, int k) {
+  return value_or_throw(try_combination(n, k));
+}
+
+//EFFECTS: prints x in decimal; ostream can't print 128-bit ints itself
+ostream & operator<<(ostream &os, uint128 x) {
+  string digits;
+  do {
+    digits.insert(digits.begin(), static_cast<char>('0' + x % 10));
+    x /= 10;
+  } while (x != 0);
+  return os << digits;
+}
+
+
+//EFFECTS: returns the answer to command f with arguments n and k, or the
+//         error: ERROR_INPUT if f is not a command
+Result<unsigned long long> try_evaluate(const string &f, int n, int k) {
+  if (f == "factorial") return try_factorial(n);
+  if (f == "combination") return try_combination(n, k);
+  return ERROR_INPUT;
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
+#ifdef EXCEPTIONS_BENCHMARK
+// one command from the input, already parsed
+struct Query {
+  string f;
+  int n;
+  int k;
+};
+
+//EFFECTS: returns count queries, of which a fraction error_rate fail: with
+//         a negative number, an answer too big, or a command that doesn't
+//         exist
+vector<Query> make_queries(int count, double error_rate, unsigned seed) {
+  mt19937 rng(seed);
+  uniform_real_distribution<double> coin(0, 1);
+  vector<Query> queries(count);
+  for (int i = 0; i < count; ++i) {
+    Query &q = queries[i];
+    bool fail = coin(rng) < error_rate;
+    q.f = (rng() % 2) ? "factorial" : "combination";
+    q.n = static_cast<int>(rng() % (FACTORIAL_MAX_64 + 1));
+    q.k = static_cast<int>(rng() % (q.n + 1));
+    if (!fail) continue;
+    switch (rng() % 3) {
+    case 0: q.n = -q.n - 1; break;
+    case 1: q.n = 100; q.k = 50; break; //100! and C(100, 50) overflow
+    default: q.f = "permutation"; break;
+    }
+  }
+  return queries;
+}
+
+int main() {
+  const int QUERIES = 200000;
+  const double error_rates[] = {0, 0.1, 0.5, 0.9};
+  for (int r = 0; r < 4; ++r) {
+    vector<Query> queries = make_queries(QUERIES, error_rates[r], 50);
+
+    // the command loop in the demo: exceptions for every error
+    unsigned long long sum = 0;
+    long long errors[4] = {0, 0, 0, 0};
+    long long start = now_ns();
+    for (int i = 0; i < QUERIES; ++i) {
+      const Query &q = queries[i];
+      try {
+        if (q.f == "factorial") {
+          sum += factorial(q.n);
+        } else if (q.f == "combination") {
+          sum += combination(q.n, q.k);
+        } else {
+          throw InputError();
+        }
+      } catch (NegativeError) {
+        ++errors[ERROR_NEGATIVE];
+      } catch (OverflowError) {
+        ++errors[ERROR_OVERFLOW];
+      } catch (...) {
+        ++errors[ERROR_INPUT];
+      }
+    }
+    double throw_ns = double(now_ns() - start) / QUERIES;
+    long long throw_checksum = static_cast<long long>(sum % 1000000007) +
+      errors[ERROR_NEGATIVE] + 3 * errors[ERROR_OVERFLOW] +
+      7 * errors[ERROR_INPUT];
+
+    // the same with error codes
+    sum = 0;
+    errors[ERROR_NEGATIVE] = errors[ERROR_OVERFLOW] = errors[ERROR_INPUT] = 0;
+    start = now_ns();
+    for (int i = 0; i < QUERIES; ++i) {
+      const Query &q = queries[i];
+      Result<unsigned long long> answer = try_evaluate(q.f, q.n, q.k);
+      if (answer.ok()) sum += answer.value();
+      else ++errors[answer.error()];
+    }
+    double result_ns = double(now_ns() - start) / QUERIES;
+    long long result_checksum = static_cast<long long>(sum % 1000000007) +
+      errors[ERROR_NEGATIVE] + 3 * errors[ERROR_OVERFLOW] +
+      7 * errors[ERROR_INPUT];
+
+    BenchmarkRow().add("group", "errors")
+                  .add("impl", "throw/catch")
+                  .add("error_rate", error_rates[r])
+                  .add("queries", QUERIES)
+                  .add("ns_per_query", throw_ns)
+                  .add("checksum", throw_checksum)
+                  .print(cout);
+    BenchmarkRow().add("group", "errors")
+                  .add("impl", "Result")
+                  .add("error_rate", error_rates[r])
+                  .add("queries", QUERIES)
+                  .add("ns_per_query", result_ns)
+                  .add("checksum", result_checksum)
+                  .print(cout);
+  }
+}
+#else
 int main() {
 
   cout << "Enter commands like this \"factorial 3\" or \"combination 4 2\"" << endl;
@@ -41,7 +298,7 @@ int main() {
 
     try {
       if (f == "factorial") {
-        cout << factorial(n) << endl;
+        cout << factorial128(n) << endl;
       } else if (f == "combination") {
         int k;
         cin >> k;
@@ -52,6 +309,8 @@ int main() {
 
     } catch (NegativeError) {
       cout << "try again with a positive number" << endl;
+    } catch (OverflowError) {
+      cout << "try again with a smaller number" << endl;
     } catch (...) {
       cout << "try again" <<endl;
     }//try-catch
@@ -59,3 +318,4 @@ int main() {
   }//while
 
 }//main
+#endif
@@ -0,0 +1,268 @@
+#ifndef BATCHPREDICATES_H
+#define BATCHPREDICATES_H
+/* BatchPredicates.h
+ *
+ * Predicates applied to whole arrays of ints at once:
+ *
+ *   int readings[N];
+ *   ...
+ *   size_t n = batch_count_if(readings, N, is_solid || is_gas);
+ *   bool hot = batch_any_of(readings, N, GreaterN(500));
+ *
+ * any_of() in 21_Functors.cpp calls the predicate once per element, and
+ * can stop after any of them, so the compiler has to test the elements one
+ * at a time.  These functions test a block of BATCH_BLOCK elements with
+ * one loop of fixed length and no early exit, which g++ -O2 compiles to
+ * vector compares, like mark_duplicates_small() in Duplicates.h.
+ * batch_any_of() stops after the first block with a match.
+ *
+ * The kernels only apply to the comparison functors of Predicates.h:
+ * GreaterN, LessN, InRange, and their combinations that simplify to an
+ * IntInterval or an IntOutside.  Each of them becomes the same single
+ * compare, on all lanes of a vector.  Any other functor is called once per
+ * element, as usual.
+ *
+ * By default the vectors are the SSE2 ones every x86-64 processor has.
+ * Compile with -march=native to let the compiler use AVX2 or AVX-512.
+ */
+
+#include <climits>     //INT_MAX, INT_MIN
+#include <cstddef>     //size_t
+#include <cstdint>     //uint64_t
+#include <type_traits> //integral_constant, is_same, true_type, false_type
+#include "Predicates.h" //IntInterval, IntOutside, IsInterval
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+// elements tested per vectorized block, and bits in a batch_mask_of() word
+static const int BATCH_BLOCK = 64;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Interface
+
+//EFFECTS: returns the number of elements of data[0..n) for which pred is
+//         true
+template <typename Predicate>
+std::size_t batch_count_if(const int data[], std::size_t n, Predicate pred);
+
+//EFFECTS: returns true if pred is true for any element of data[0..n)
+template <typename Predicate>
+bool batch_any_of(const int data[], std::size_t n, Predicate pred);
+
+//REQUIRES: mask has room for (n + 63) / 64 words
+//MODIFIES: mask
+//EFFECTS:  sets bit i % 64 of mask[i / 64] if pred is true for data[i], and
+//          clears it if not.  Bits past n in the last word are cleared.
+template <typename Predicate>
+void batch_mask_of(const int data[], std::size_t n, Predicate pred,
+                   std::uint64_t mask[]);
+
+//MODIFIES: data
+//EFFECTS:  reorders data[0..n) so that the elements for which pred is true
+//          come first, in their original order, and returns how many there
+//          are.  The other elements may change order, as in std::partition.
+template <typename Predicate>
+std::size_t batch_partition(int data[], std::size_t n, Predicate pred);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+
+struct BatchTest {
+  //OVERVIEW: a comparison functor in the form the kernels use.  x matches
+  //          if x - lo <= span as unsigned ints, or if it doesn't, when
+  //          outside is true.
+  unsigned lo;
+  unsigned span;
+  bool outside;
+
+  // no branches, so that it vectorizes
+  bool operator() (int x) const {
+    return (static_cast<unsigned>(x) - lo <= span) != outside;
+  }
+};
+
+//EFFECTS: returns the BatchTest for the ints in interval, or outside it
+inline BatchTest batch_test(const IntInterval &interval, bool outside) {
+  BatchTest test;
+  // Only ints are tested, so the part of the interval outside the range
+  // of int doesn't matter.  Without it, hi - lo fits in an unsigned.
+  long long lo = interval.empty() ? 0 : interval.get_lo();
+  long long hi = interval.empty() ? -1 : interval.get_hi();
+  if (lo < INT_MIN) lo = INT_MIN;
+  if (hi > INT_MAX) hi = INT_MAX;
+  if (hi < lo) {
+    // an empty interval is the complement of every int
+    test.lo = static_cast<unsigned>(INT_MIN);
+    test.span = ~0u;
+    test.outside = !outside;
+    return test;
+  }
+  // wraps around modulo 2^32, the same way x - lo does
+  test.lo = static_cast<unsigned>(lo);
+  test.span = static_cast<unsigned>(hi - lo);
+  test.outside = outside;
+  return test;
+}
+
+template <typename P>
+typename std::enable_if<IsInterval<P>::value, BatchTest>::type
+batch_test(const P &p) {
+  return batch_test(p.interval(), false);
+}
+
+inline BatchTest batch_test(const IntOutside &p) {
+  return batch_test(p.get_gap(), true);
+}
+
+// IsBatchTestable<P>::value is true if P has a BatchTest
+template <typename P>
+struct IsBatchTestable
+  : public std::integral_constant<bool, IsInterval<P>::value ||
+                                        std::is_same<P, IntOutside>::value> {};
+
+// Each function below has two versions: one for predicates that have a
+// BatchTest, selected with std::true_type, and one for any other functor.
+
+template <typename Predicate>
+std::size_t batch_count(const int data[], std::size_t n, Predicate pred,
+                        std::true_type) {
+  const BatchTest test = batch_test(pred);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for (; i + BATCH_BLOCK <= n; i += BATCH_BLOCK) {
+    unsigned block_count = 0;
+    for (int j = 0; j < BATCH_BLOCK; ++j) block_count += test(data[i + j]);
+    count += block_count;
+  }
+  for (; i < n; ++i) count += test(data[i]);
+  return count;
+}
+
+template <typename Predicate>
+std::size_t batch_count(const int data[], std::size_t n, Predicate pred,
+                        std::false_type) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; ++i) count += pred(data[i]) ? 1 : 0;
+  return count;
+}
+
+template <typename Predicate>
+bool batch_any(const int data[], std::size_t n, Predicate pred,
+               std::true_type) {
+  const BatchTest test = batch_test(pred);
+  std::size_t i = 0;
+  for (; i + BATCH_BLOCK <= n; i += BATCH_BLOCK) {
+    // the whole block, then one branch
+    unsigned found = 0;
+    for (int j = 0; j < BATCH_BLOCK; ++j) found |= test(data[i + j]);
+    if (found) return true;
+  }
+  for (; i < n; ++i) {
+    if (test(data[i])) return true;
+  }
+  return false;
+}
+
+template <typename Predicate>
+bool batch_any(const int data[], std::size_t n, Predicate pred,
+               std::false_type) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (pred(data[i])) return true;
+  }
+  return false;
+}
+
+template <typename Predicate>
+void batch_mask(const int data[], std::size_t n, Predicate pred,
+                std::uint64_t mask[], std::true_type) {
+  const BatchTest test = batch_test(pred);
+  std::size_t i = 0;
+  for (; i + BATCH_BLOCK <= n; i += BATCH_BLOCK) {
+    // Test into bytes, which vectorizes, then gather 8 bytes at a time
+    // into 8 bits.  Multiplying by MAGIC adds up a copy of each byte's low
+    // bit shifted to its place in the top byte, with no carries.
+    const std::uint64_t MAGIC = 0x0102040810204080ULL;
+    unsigned char hits[BATCH_BLOCK];
+    for (int j = 0; j < BATCH_BLOCK; ++j) hits[j] = test(data[i + j]);
+    std::uint64_t bits = 0;
+    for (int j = 0; j < BATCH_BLOCK; j += 8) {
+      std::uint64_t bytes = 0; //hits[j + k] in byte k
+      for (int k = 0; k < 8; ++k) {
+        bytes |= static_cast<std::uint64_t>(hits[j + k]) << (8 * k);
+      }
+      bits |= ((bytes * MAGIC) >> 56) << j;
+    }
+    mask[i / BATCH_BLOCK] = bits;
+  }
+  if (i == n) return;
+  std::uint64_t bits = 0;
+  for (std::size_t j = 0; i + j < n; ++j) {
+    bits |= static_cast<std::uint64_t>(test(data[i + j])) << j;
+  }
+  mask[i / BATCH_BLOCK] = bits;
+}
+
+template <typename Predicate>
+void batch_mask(const int data[], std::size_t n, Predicate pred,
+                std::uint64_t mask[], std::false_type) {
+  for (std::size_t i = 0; i < n; i += 64) mask[i / 64] = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (pred(data[i])) mask[i / 64] |= std::uint64_t(1) << (i % 64);
+  }
+}
+
+//MODIFIES: data
+//EFFECTS:  like batch_partition(), with match(x) as the predicate.  Each
+//          element is swapped with the first non-match whether it matches
+//          or not, so there is no branch to mispredict.
+template <typename Match>
+std::size_t batch_partition_with(int data[], std::size_t n, Match &match) {
+  std::size_t matches = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    // data[matches..i) are non-matches
+    int x = data[i];
+    bool is_match = match(x);
+    data[i] = data[matches];
+    data[matches] = x;
+    matches += is_match;
+  }
+  return matches;
+}
+
+template <typename Predicate>
+std::size_t batch_part(int data[], std::size_t n, Predicate pred,
+                       std::true_type) {
+  BatchTest test = batch_test(pred);
+  return batch_partition_with(data, n, test);
+}
+
+template <typename Predicate>
+std::size_t batch_part(int data[], std::size_t n, Predicate pred,
+                       std::false_type) {
+  return batch_partition_with(data, n, pred);
+}
+
+template <typename Predicate>
+std::size_t batch_count_if(const int data[], std::size_t n, Predicate pred) {
+  return batch_count(data, n, pred, IsBatchTestable<Predicate>());
+}
+
+template <typename Predicate>
+bool batch_any_of(const int data[], std::size_t n, Predicate pred) {
+  return batch_any(data, n, pred, IsBatchTestable<Predicate>());
+}
+
+template <typename Predicate>
+void batch_mask_of(const int data[], std::size_t n, Predicate pred,
+                   std::uint64_t mask[]) {
+  batch_mask(data, n, pred, mask, IsBatchTestable<Predicate>());
+}
+
+template <typename Predicate>
+std::size_t batch_partition(int data[], std::size_t n, Predicate pred) {
+  return batch_part(data, n, pred, IsBatchTestable<Predicate>());
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+/* Benchmark.h
+ *
+ * Measurement utilities shared by the benchmark drivers: a monotonic clock,
+ * latency percentiles, global allocation counts, peak memory and one-line
+ * JSON output so that results can be collected by scripts.
+ *
+ * NOTE: this header replaces the global operator new and operator delete in
+ * order to count allocations.  Include it from exactly one .cpp file, the
+ * one that defines main().
+ */
+
+#include <algorithm>      //sort
+#include <atomic>         //atomic
+#include <chrono>         //steady_clock
+#include <cstddef>        //size_t, max_align_t
+#include <cstdint>        //uintptr_t
+#include <cstdlib>        //malloc, free, exit
+#include <iostream>       //ostream, cerr
+#include <new>            //bad_alloc
+#include <sstream>        //ostringstream
+#include <string>         //string
+#include <vector>         //vector
+#include <sys/resource.h> //getrusage
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation counting
+
+struct AllocationStats {
+  //OVERVIEW: process-wide counts maintained by operator new and delete
+  std::atomic<long long> allocs;     //number of calls to operator new
+  std::atomic<long long> frees;      //number of calls to operator delete
+  std::atomic<long long> live_bytes; //bytes currently allocated
+  std::atomic<long long> peak_bytes; //high water mark of live_bytes
+};
+
+static AllocationStats g_alloc_stats;
+
+//EFFECTS: returns the number of bytes currently allocated with operator new
+inline long long live_bytes() {
+  return g_alloc_stats.live_bytes.load(std::memory_order_relaxed);
+}
+
+//MODIFIES: g_alloc_stats
+//EFFECTS: restarts the high water mark at the current number of live bytes
+inline void reset_peak_bytes() {
+  g_alloc_stats.peak_bytes.store(live_bytes(), std::memory_order_relaxed);
+}
+
+// Each block carries its size in a header so that operator delete can
+// account for it.  The header is max_align_t sized to keep the alignment
+// guarantee of operator new.
+static const std::size_t ALLOC_HEADER = alignof(std::max_align_t);
+
+void * operator new(std::size_t size) {
+  char *base = static_cast<char *>(std::malloc(size + ALLOC_HEADER));
+  if (!base) throw std::bad_alloc();
+  *reinterpret_cast<std::size_t *>(base) = size;
+
+  g_alloc_stats.allocs.fetch_add(1, std::memory_order_relaxed);
+  long long live = g_alloc_stats.live_bytes.fetch_add(
+    size, std::memory_order_relaxed) + size;
+  long long peak = g_alloc_stats.peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !g_alloc_stats.peak_bytes.compare_exchange_weak(
+           peak, live, std::memory_order_relaxed)) {}
+
+  return base + ALLOC_HEADER;
+}
+
+void operator delete(void *p) noexcept {
+  if (!p) return;
+  // step back to the header through an integer, GCC's -Warray-bounds does not
+  // know that the block started before p
+  char *base = reinterpret_cast<char *>(
+    reinterpret_cast<std::uintptr_t>(p) - ALLOC_HEADER);
+  std::size_t size = *reinterpret_cast<std::size_t *>(base);
+  g_alloc_stats.frees.fetch_add(1, std::memory_order_relaxed);
+  g_alloc_stats.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+  std::free(base);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  operator delete(p);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Clocks and memory
+
+//EFFECTS: returns the current time of a monotonic clock in nanoseconds
+inline long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//EFFECTS: returns the peak resident set size of this process in kilobytes
+inline long peak_rss_kb() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Checks
+
+//EFFECTS: if ok is false, prints what to std::cerr and exits with status
+//         1.  Benchmarks are compiled with -DNDEBUG, so their checks of the
+//         code under test can't use assert.
+inline void bench_check(bool ok, const std::string &what) {
+  if (ok) return;
+  std::cerr << "Check failed: " << what << std::endl;
+  std::exit(1);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+class LatencyRecorder {
+  //OVERVIEW: collects latency samples in nanoseconds and reports percentiles
+ public:
+
+  //EFFECTS: creates an empty recorder with room for expected samples, so
+  //         that add() does not allocate while a benchmark is running
+  LatencyRecorder(std::size_t expected = 0) { samples.reserve(expected); }
+
+  //MODIFIES: this
+  //EFFECTS:  records one sample
+  void add(double ns) { samples.push_back(ns); }
+
+  //REQUIRES: 0 <= p <= 100
+  //MODIFIES: this (samples are sorted)
+  //EFFECTS:  returns the p-th percentile sample, 0 if there are no samples
+  double percentile(double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    std::size_t i = static_cast<std::size_t>(p / 100 * (samples.size() - 1));
+    return samples[i];
+  }
+
+ private:
+  std::vector<double> samples;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+class BenchmarkRow {
+  //OVERVIEW: one benchmark result, printed as a single-line JSON object
+ public:
+
+  //MODIFIES: this
+  //EFFECTS:  appends a field, returns this row so calls can be chained
+  BenchmarkRow & add(const char *key, const std::string &value) {
+    return add_raw(key, "\"" + value + "\"");
+  }
+
+  BenchmarkRow & add(const char *key, const char *value) {
+    return add(key, std::string(value));
+  }
+
+  BenchmarkRow & add(const char *key, long long value) {
+    std::ostringstream os;
+    os << value;
+    return add_raw(key, os.str());
+  }
+
+  BenchmarkRow & add(const char *key, int value) {
+    return add(key, static_cast<long long>(value));
+  }
+
+  BenchmarkRow & add(const char *key, double value) {
+    std::ostringstream os;
+    os.precision(4);
+    os << std::fixed << value;
+    return add_raw(key, os.str());
+  }
+
+  //EFFECTS: prints this row to os, followed by a newline
+  void print(std::ostream &os) const {
+    os << "{" << fields << "}" << std::endl;
+  }
+
+ private:
+  std::string fields;
+
+  BenchmarkRow & add_raw(const char *key, const std::string &value) {
+    if (!fields.empty()) fields += ", ";
+    fields += "\"" + std::string(key) + "\": " + value;
+    return *this;
+  }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+/* BloomFilter.h
+ *
+ * Blocked Bloom filter over ints.  A key hashes to one 64-byte block (one
+ * cache line) and sets one bit in each of the block's eight 64-bit words, so
+ * a lookup touches a single cache line.  A negative answer is always right;
+ * a positive answer is wrong with a small probability (a false positive).
+ *
+ * Uses dynamic memory, with the Big Three for deep copies.
+ */
+
+#include <cassert>  //assert
+#include <cstdint>  //uint64_t, uintptr_t
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// BloomFilter declaration
+class BloomFilter {
+  //OVERVIEW: approximate set of ints with no false negatives
+ public:
+
+  //REQUIRES: expected > 0
+  //EFFECTS:  creates an empty filter sized for expected keys
+  BloomFilter(int expected = 100);
+
+  //EFFECTS: copy constructor creates a (deep) copy of other
+  BloomFilter(const BloomFilter &other);
+
+  //EFFECTS: destroys this BloomFilter
+  ~BloomFilter();
+
+  //EFFECTS: assignment operator does a deep copy
+  BloomFilter & operator= (const BloomFilter &rhs);
+
+  //MODIFIES: this
+  //EFFECTS:  adds v to the filter
+  void insert(int v);
+
+  //EFFECTS: returns false if v was definitely never inserted, true if it
+  //         probably was
+  bool maybe_contains(int v) const;
+
+  //MODIFIES: this
+  //EFFECTS:  removes all keys
+  void clear();
+
+  //EFFECTS: returns the number of keys the filter was sized for.  Beyond
+  //         this the false positive rate climbs quickly.
+  int capacity() const { return expected; }
+
+ private:
+  static const int WORDS_PER_BLOCK = 8;  //8 x 64 bits = one 64-byte line
+  static const int BITS_PER_KEY = 16;    //about 0.1% false positives
+
+  //Blocks live in raw, which is allocated with one spare block so that
+  //blocks can start on a 64-byte boundary
+  std::uint64_t *raw;
+  std::uint64_t *blocks;
+  int num_blocks;
+  int expected;
+
+  //MODIFIES: this
+  //EFFECTS:  allocates zeroed storage for num_blocks blocks
+  void allocate();
+
+  //EFFECTS: returns a well-mixed 64-bit hash of v
+  static std::uint64_t hash(int v);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// BloomFilter implementation
+
+inline BloomFilter::BloomFilter(int expected_in)
+  : expected(expected_in) {
+  assert(expected > 0);
+  num_blocks = (expected * BITS_PER_KEY + 511) / 512;
+  allocate();
+}
+
+inline BloomFilter::BloomFilter(const BloomFilter &other)
+  : num_blocks(other.num_blocks), expected(other.expected) {
+  allocate();
+  for (int i = 0; i < num_blocks * WORDS_PER_BLOCK; ++i)
+    blocks[i] = other.blocks[i];
+}
+
+inline BloomFilter::~BloomFilter() {
+  delete[] raw;
+}
+
+inline BloomFilter & BloomFilter::operator= (const BloomFilter &rhs) {
+  if (this == &rhs) return *this; //check for self assignment
+  delete[] raw;
+  num_blocks = rhs.num_blocks;
+  expected = rhs.expected;
+  allocate();
+  for (int i = 0; i < num_blocks * WORDS_PER_BLOCK; ++i)
+    blocks[i] = rhs.blocks[i];
+  return *this;
+}
+
+inline void BloomFilter::allocate() {
+  raw = new std::uint64_t[(num_blocks + 1) * WORDS_PER_BLOCK];
+  std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw);
+  int skip = static_cast<int>((64 - addr % 64) % 64 / sizeof(std::uint64_t));
+  blocks = raw + skip;
+  clear();
+}
+
+inline void BloomFilter::clear() {
+  for (int i = 0; i < num_blocks * WORDS_PER_BLOCK; ++i)
+    blocks[i] = 0;
+}
+
+inline std::uint64_t BloomFilter::hash(int v) {
+  // splitmix64 finalizer
+  std::uint64_t h = static_cast<std::uint32_t>(v);
+  h += 0x9e3779b97f4a7c15ULL;
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+// The low 32 bits of the hash pick the block.  The high 32 bits, multiplied
+// by a different odd constant per word, pick the bit inside each word.
+static const std::uint64_t BLOOM_SALT[8] = {
+  0x47b6137bULL, 0x44974d91ULL, 0x8824ad5bULL, 0xa2b7289dULL,
+  0x705495c7ULL, 0x2df1424bULL, 0x9efc4947ULL, 0x5c6bfb31ULL
+};
+
+inline void BloomFilter::insert(int v) {
+  std::uint64_t h = hash(v);
+  std::uint64_t *block =
+    blocks + (h & 0xffffffffULL) % num_blocks * WORDS_PER_BLOCK;
+  std::uint32_t key = static_cast<std::uint32_t>(h >> 32);
+  for (int i = 0; i < WORDS_PER_BLOCK; ++i) {
+    std::uint32_t bit = static_cast<std::uint32_t>(key * BLOOM_SALT[i]) >> 26;
+    block[i] |= std::uint64_t(1) << bit;
+  }
+}
+
+inline bool BloomFilter::maybe_contains(int v) const {
+  std::uint64_t h = hash(v);
+  const std::uint64_t *block =
+    blocks + (h & 0xffffffffULL) % num_blocks * WORDS_PER_BLOCK;
+  std::uint32_t key = static_cast<std::uint32_t>(h >> 32);
+  // no early exit: all eight words are in the same cache line, and a
+  // branch-free test is cheaper than a mispredicted one
+  std::uint64_t missing = 0;
+  for (int i = 0; i < WORDS_PER_BLOCK; ++i) {
+    std::uint32_t bit = static_cast<std::uint32_t>(key * BLOOM_SALT[i]) >> 26;
+    missing |= ~block[i] & (std::uint64_t(1) << bit);
+  }
+  return missing == 0;
+}
+
+#endif
@@ -0,0 +1,507 @@
+#ifndef CONCURRENTLIST_H
+#define CONCURRENTLIST_H
+/* ConcurrentList.h
+ *
+ * Thread-safe work queues with the push_back/pop_front semantics of List,
+ * for producer and consumer threads that would otherwise share a List
+ * behind a mutex.  None of them take a lock.
+ *
+ *   SpscRing<T>    one producer, one consumer, bounded ring buffer
+ *   MpmcQueue<T>   any number of producers and consumers (Michael-Scott)
+ *   MpscQueue<T>   any number of producers, one consumer, intrusive: T
+ *                  derives from MpscHook and the queue never allocates
+ *
+ * Since another thread can empty the queue at any moment, there is no
+ * empty()/front()/pop_front() sequence.  try_pop_front() does all three.
+ */
+
+#include <algorithm> //sort, binary_search
+#include <atomic>    //atomic
+#include <cassert>   //assert
+#include <cstddef>   //size_t
+#include <new>       //placement new
+#include <stdexcept> //runtime_error
+#include <utility>   //move, forward
+#include <vector>    //vector
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SpscRing
+template <typename T>
+class SpscRing {
+  //OVERVIEW: bounded FIFO queue for exactly one producer thread and one
+  //          consumer thread
+ public:
+
+  //REQUIRES: capacity_in > 0
+  //EFFECTS:  creates an empty ring holding at least capacity_in elements
+  explicit SpscRing(std::size_t capacity_in = 1024);
+
+  //REQUIRES: no other thread is using the ring
+  //EFFECTS:  destroys the ring and any elements still in it
+  ~SpscRing();
+
+  //REQUIRES: called only from the producer thread
+  //MODIFIES: this
+  //EFFECTS:  inserts datum at the back and returns true, or returns false
+  //          if the ring is full
+  bool try_push_back(const T &datum) { return try_emplace_back(datum); }
+  bool try_push_back(T &&datum) { return try_emplace_back(std::move(datum)); }
+
+  template <typename... Args>
+  bool try_emplace_back(Args&&... args);
+
+  //REQUIRES: called only from the consumer thread
+  //MODIFIES: this, out
+  //EFFECTS:  moves the front element into out, removes it and returns
+  //          true, or returns false if the ring is empty
+  bool try_pop_front(T &out);
+
+  //EFFECTS: returns the number of elements the ring can hold
+  std::size_t capacity() const { return mask + 1; }
+
+ private:
+  T * slot(std::size_t i) { return reinterpret_cast<T *>(storage) + (i & mask); }
+
+  // Indices only grow; slot(i) wraps them.  The producer owns tail and the
+  // consumer owns head, and each keeps a stale copy of the other's index so
+  // that it reads the shared one only when the ring looks full or empty.
+  // Each index is on its own cache line so the two threads don't fight
+  // over one.
+  alignas(64) std::atomic<std::size_t> head; //next element to pop
+  std::size_t cached_tail;                   //consumer's copy of tail
+  alignas(64) std::atomic<std::size_t> tail; //next free slot
+  std::size_t cached_head;                   //producer's copy of head
+  alignas(64) std::size_t mask;              //capacity - 1, a power of 2 - 1
+  unsigned char *storage;
+
+  // a ring owns its elements and is shared between threads, so it can't be
+  // copied
+  SpscRing(const SpscRing &);
+  SpscRing & operator= (const SpscRing &);
+};
+
+template <typename T>
+SpscRing<T>::SpscRing(std::size_t capacity_in)
+  : head(0), cached_tail(0), tail(0), cached_head(0) {
+  assert(capacity_in > 0);
+  std::size_t capacity = 1;
+  while (capacity < capacity_in) capacity *= 2;
+  mask = capacity - 1;
+  storage = static_cast<unsigned char *>(::operator new(capacity * sizeof(T)));
+}
+
+template <typename T>
+SpscRing<T>::~SpscRing() {
+  for (std::size_t i = head.load(); i != tail.load(); ++i) slot(i)->~T();
+  ::operator delete(storage);
+}
+
+template <typename T>
+template <typename... Args>
+bool SpscRing<T>::try_emplace_back(Args&&... args) {
+  std::size_t t = tail.load(std::memory_order_relaxed);
+  if (t - cached_head > mask) {
+    cached_head = head.load(std::memory_order_acquire);
+    if (t - cached_head > mask) return false;
+  }
+  new (slot(t)) T(std::forward<Args>(args)...);
+  tail.store(t + 1, std::memory_order_release); //publishes the element
+  return true;
+}
+
+template <typename T>
+bool SpscRing<T>::try_pop_front(T &out) {
+  std::size_t h = head.load(std::memory_order_relaxed);
+  if (h == cached_tail) {
+    cached_tail = tail.load(std::memory_order_acquire);
+    if (h == cached_tail) return false;
+  }
+  T *p = slot(h);
+  out = std::move(*p);
+  p->~T();
+  head.store(h + 1, std::memory_order_release); //hands the slot back
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// HazardPointers
+class HazardPointers {
+  //OVERVIEW: safe memory reclamation for lock-free structures.  Before a
+  //          thread follows a shared pointer it publishes the pointer as a
+  //          hazard.  A removed node is retired instead of deleted, and is
+  //          deleted only once no thread has it as a hazard.
+ public:
+  static const int SLOTS = 2;         //hazards per thread
+  static const int MAX_THREADS = 128; //threads using hazards at once
+
+  //MODIFIES: the calling thread's hazards
+  //EFFECTS:  gives the calling thread a record of hazards, if it doesn't
+  //          have one yet.  Throws std::runtime_error if MAX_THREADS other
+  //          threads have one.  The functions below do this on first use.
+  static void claim() { mine(); }
+
+  //REQUIRES: 0 <= slot < SLOTS
+  //MODIFIES: the calling thread's hazards
+  //EFFECTS:  loads src and protects the result with the given slot.  The
+  //          returned node can't be deleted until the slot is cleared.
+  template <typename Node>
+  static Node * protect(int slot, const std::atomic<Node *> &src);
+
+  //MODIFIES: the calling thread's hazards
+  //EFFECTS:  stops protecting the node in slot
+  static void clear(int slot);
+
+  //REQUIRES: p has been unlinked, so no thread can newly reach it
+  //MODIFIES: the calling thread's retired nodes
+  //EFFECTS:  calls deleter(p) once no thread has p as a hazard
+  static void retire(void *p, void (*deleter)(void *));
+
+ private:
+  struct Retired {
+    void *p;
+    void (*deleter)(void *);
+  };
+
+  // A thread claims a Record the first time it uses hazards, and gives it
+  // back when it exits.  Its retired nodes stay with the Record for the next
+  // thread to delete.
+  struct Record {
+    std::atomic<bool> owned;
+    std::atomic<void *> hazard[SLOTS];
+    std::vector<Retired> retired; //only touched by the owner
+  };
+
+  // gives the calling thread's Record back when the thread exits
+  struct Owner {
+    Record *record;
+    Owner();
+    ~Owner();
+  };
+
+  // scan() once this many nodes are retired, so that each scan deletes
+  // most of what it looks at
+  static const std::size_t SCAN_THRESHOLD = 2 * SLOTS * MAX_THREADS;
+
+  static Record * records() {
+    static Record all[MAX_THREADS];
+    return all;
+  }
+
+  static Record & mine() {
+    static thread_local Owner owner;
+    return *owner.record;
+  }
+
+  //MODIFIES: r
+  //EFFECTS:  deletes the retired nodes of r that no thread has as a hazard
+  static void scan(Record &r);
+};
+
+inline HazardPointers::Owner::Owner() : record(0) {
+  Record *all = records();
+  for (int i = 0; i < MAX_THREADS; ++i) {
+    bool expected = false;
+    if (!all[i].owned.load(std::memory_order_relaxed) &&
+        all[i].owned.compare_exchange_strong(expected, true)) {
+      record = &all[i];
+      return;
+    }
+  }
+  // Thrown out of the initialization of the thread_local Owner in mine(),
+  // so the next call from this thread tries again.
+  throw std::runtime_error(
+    "HazardPointers: more than MAX_THREADS threads at once");
+}
+
+inline HazardPointers::Owner::~Owner() {
+  for (int i = 0; i < SLOTS; ++i) record->hazard[i].store(0);
+  scan(*record);
+  record->owned.store(false, std::memory_order_release);
+}
+
+template <typename Node>
+Node * HazardPointers::protect(int slot, const std::atomic<Node *> &src) {
+  std::atomic<void *> &hazard = mine().hazard[slot];
+  Node *p = src.load();
+  for (;;) {
+    hazard.store(p);
+    // if src still holds p, p was reachable after the hazard was visible,
+    // so any later scan() will see it
+    Node *again = src.load();
+    if (again == p) return p;
+    p = again;
+  }
+}
+
+inline void HazardPointers::clear(int slot) {
+  mine().hazard[slot].store(0, std::memory_order_release);
+}
+
+inline void HazardPointers::retire(void *p, void (*deleter)(void *)) {
+  Record &r = mine();
+  Retired item = { p, deleter };
+  r.retired.push_back(item);
+  if (r.retired.size() >= SCAN_THRESHOLD) scan(r);
+}
+
+inline void HazardPointers::scan(Record &r) {
+  std::vector<void *> hazards;
+  Record *all = records();
+  for (int i = 0; i < MAX_THREADS; ++i) {
+    for (int j = 0; j < SLOTS; ++j) {
+      void *h = all[i].hazard[j].load();
+      if (h) hazards.push_back(h);
+    }
+  }
+  std::sort(hazards.begin(), hazards.end());
+
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < r.retired.size(); ++i) {
+    if (std::binary_search(hazards.begin(), hazards.end(), r.retired[i].p)) {
+      r.retired[kept++] = r.retired[i];
+    } else {
+      r.retired[i].deleter(r.retired[i].p);
+    }
+  }
+  r.retired.resize(kept);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// MpmcQueue
+template <typename T>
+class MpmcQueue {
+  //OVERVIEW: unbounded FIFO queue for any number of producer and consumer
+  //          threads.  This is the Michael-Scott queue: a singly-linked
+  //          list whose first node is a dummy, with front and back
+  //          pointers that are advanced with compare-and-swap.  Removed
+  //          nodes are reclaimed with HazardPointers.
+  //
+  //          At most HazardPointers::MAX_THREADS threads can use MpmcQueues
+  //          at once.  A thread holds its place from its first push_back()
+  //          or try_pop_front() until it exits, and each of these throws
+  //          std::runtime_error, leaving the queue as it was, if there is no
+  //          place left.
+ public:
+
+  //EFFECTS: creates an empty queue
+  MpmcQueue();
+
+  //REQUIRES: no other thread is using the queue
+  //EFFECTS:  destroys the queue and any elements still in it
+  ~MpmcQueue();
+
+  //MODIFIES: this
+  //EFFECTS:  inserts datum at the back of the queue
+  void push_back(const T &datum) { emplace_back(datum); }
+  void push_back(T &&datum) { emplace_back(std::move(datum)); }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+
+  //MODIFIES: this, out
+  //EFFECTS:  moves the front element into out, removes it and returns
+  //          true, or returns false if the queue is empty
+  bool try_pop_front(T &out);
+
+ private:
+  // Only the node after the dummy and later ones hold an element.  The
+  // element is moved out by the thread that makes its node the new dummy.
+  struct Node {
+    std::atomic<Node *> next;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    Node() : next(0) {}
+    T * datum() { return reinterpret_cast<T *>(storage); }
+  };
+
+  static void delete_node(void *p) { delete static_cast<Node *>(p); }
+
+  alignas(64) std::atomic<Node *> front_ptr; //the dummy node
+  alignas(64) std::atomic<Node *> back_ptr;  //the last node, or close to it
+
+  // a queue is shared between threads, so it can't be copied
+  MpmcQueue(const MpmcQueue &);
+  MpmcQueue & operator= (const MpmcQueue &);
+};
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue() {
+  Node *dummy = new Node;
+  front_ptr.store(dummy);
+  back_ptr.store(dummy);
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() {
+  Node *p = front_ptr.load();
+  Node *next = p->next.load();
+  delete p; //the dummy has no element
+  for (p = next; p != 0; p = next) {
+    next = p->next.load();
+    p->datum()->~T();
+    delete p;
+  }
+}
+
+template <typename T>
+template <typename... Args>
+void MpmcQueue<T>::emplace_back(Args&&... args) {
+  HazardPointers::claim(); //throws before anything is allocated
+  Node *n = new Node;
+  try {
+    new (n->datum()) T(std::forward<Args>(args)...);
+  } catch (...) {
+    delete n;
+    throw;
+  }
+
+  for (;;) {
+    Node *back = HazardPointers::protect(0, back_ptr);
+    Node *next = back->next.load();
+    if (back != back_ptr.load()) continue;
+    if (next != 0) {
+      // another producer linked a node but hasn't moved back_ptr yet, so
+      // help it along
+      back_ptr.compare_exchange_weak(back, next);
+      continue;
+    }
+    if (back->next.compare_exchange_weak(next, n)) {
+      back_ptr.compare_exchange_strong(back, n); //fails if someone helped
+      break;
+    }
+  }
+  HazardPointers::clear(0);
+}
+
+template <typename T>
+bool MpmcQueue<T>::try_pop_front(T &out) {
+  for (;;) {
+    Node *front = HazardPointers::protect(0, front_ptr);
+    Node *back = back_ptr.load();
+    Node *next = HazardPointers::protect(1, front->next);
+    if (front != front_ptr.load()) continue;
+    if (next == 0) {
+      HazardPointers::clear(0);
+      HazardPointers::clear(1);
+      return false;
+    }
+    if (front == back) {
+      // back_ptr is behind a node that is already linked
+      back_ptr.compare_exchange_weak(back, next);
+      continue;
+    }
+    if (front_ptr.compare_exchange_strong(front, next)) {
+      // next is the new dummy.  Its element is ours, and our hazard keeps
+      // the node alive even if other consumers move past it.
+      out = std::move(*next->datum());
+      next->datum()->~T();
+      HazardPointers::clear(0);
+      HazardPointers::clear(1);
+      HazardPointers::retire(front, &delete_node);
+      return true;
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// MpscQueue
+struct MpscHook {
+  //OVERVIEW: link embedded in every object that goes into an MpscQueue
+  std::atomic<MpscHook *> mpsc_next;
+  MpscHook() : mpsc_next(0) {}
+};
+
+template <typename T>
+class MpscQueue {
+  //OVERVIEW: unbounded FIFO queue of T objects for any number of producer
+  //          threads and one consumer thread.  T must derive from MpscHook.
+  //          The queue stores pointers to the caller's objects and links
+  //          them through their hooks, so it never allocates, and nothing
+  //          needs reclaiming: an object belongs to the caller again as
+  //          soon as it is popped.
+ public:
+
+  //EFFECTS: creates an empty queue
+  MpscQueue();
+
+  //REQUIRES: item is not in any MpscQueue, and stays alive until popped
+  //MODIFIES: this, item
+  //EFFECTS:  inserts item at the back of the queue
+  void push_back(T *item);
+
+  //REQUIRES: called only from the consumer thread
+  //MODIFIES: this
+  //EFFECTS:  removes and returns the front item, or returns 0 if the queue
+  //          is empty.  It may also return 0 for a moment while a producer
+  //          is halfway through push_back(); try again later.
+  T * try_pop_front();
+
+ private:
+  //Producers swing back_ptr to their item and then link the old back to
+  //it.  The consumer owns front_ptr.  The stub keeps the list non-empty so
+  //that a producer never has to touch front_ptr.
+  alignas(64) std::atomic<MpscHook *> back_ptr;
+  alignas(64) MpscHook *front_ptr;
+  MpscHook stub;
+
+  //MODIFIES: this
+  //EFFECTS:  links hook at the back of the queue
+  void link(MpscHook *hook);
+
+  // the stub is part of the queue, so it can't be copied
+  MpscQueue(const MpscQueue &);
+  MpscQueue & operator= (const MpscQueue &);
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue() : back_ptr(&stub), front_ptr(&stub) {}
+
+template <typename T>
+void MpscQueue<T>::link(MpscHook *hook) {
+  hook->mpsc_next.store(0, std::memory_order_relaxed);
+  MpscHook *prev = back_ptr.exchange(hook, std::memory_order_acq_rel);
+  // until this store, the consumer sees the queue end at prev
+  prev->mpsc_next.store(hook, std::memory_order_release);
+}
+
+template <typename T>
+void MpscQueue<T>::push_back(T *item) {
+  link(item);
+}
+
+template <typename T>
+T * MpscQueue<T>::try_pop_front() {
+  MpscHook *front = front_ptr;
+  MpscHook *next = front->mpsc_next.load(std::memory_order_acquire);
+  if (front == &stub) {
+    if (next == 0) return 0;
+    front_ptr = front = next;
+    next = next->mpsc_next.load(std::memory_order_acquire);
+  }
+  if (next != 0) {
+    front_ptr = next;
+    return static_cast<T *>(front);
+  }
+
+  // front is the last linked item.  If a producer has already swung
+  // back_ptr past it, its link isn't visible yet.
+  if (front != back_ptr.load(std::memory_order_acquire)) return 0;
+
+  // Put the stub behind front so that front can be handed out without
+  // leaving the queue empty of nodes
+  link(&stub);
+  next = front->mpsc_next.load(std::memory_order_acquire);
+  if (next != 0) {
+    front_ptr = next;
+    return static_cast<T *>(front);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef CONTAINERTRACE_H
+#define CONTAINERTRACE_H
+/* ContainerTrace.h
+ *
+ * Tracing hooks for container operations.  Containers call trace_op() from
+ * push_front(), pop_front() and friends.  What happens then is chosen at
+ * compile time:
+ *
+ *   (default)                     nothing.  trace_op() is an empty inline
+ *                                 function and generates no code.
+ *   -DCONTAINER_TRACE             count each kind of operation
+ *   -DCONTAINER_TRACE_LOG=N       also keep the last N operations of each
+ *                                 thread in a ring buffer
+ *   -DCONTAINER_TRACE_TIMESTAMPS  also time-stamp each logged operation
+ *
+ * The last two imply CONTAINER_TRACE.  Counts and log are kept per thread,
+ * so recording an event never needs a lock or an atomic instruction.
+ *
+ *   $ g++ -DCONTAINER_TRACE_LOG=16 -DCONTAINER_TRACE_TIMESTAMPS 18_IntList.cpp
+ */
+
+#include <iostream> //ostream
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+#if defined(CONTAINER_TRACE_TIMESTAMPS) || defined(CONTAINER_TRACE_LOG)
+#ifndef CONTAINER_TRACE
+#define CONTAINER_TRACE
+#endif
+#endif
+
+#ifdef CONTAINER_TRACE
+#include <chrono>   //steady_clock
+#include <cstddef>  //size_t
+#endif
+
+
+// Kinds of traced operations
+enum TraceOp {
+  TRACE_PUSH_FRONT,
+  TRACE_PUSH_BACK,
+  TRACE_POP_FRONT,
+  TRACE_POP_BACK,
+  TRACE_INSERT, //insert at an Iterator
+  TRACE_ERASE,  //erase at an Iterator
+  TRACE_COPY,   //copy of a whole container
+  TRACE_SPLICE, //nodes moved between containers without copying
+  TRACE_OP_COUNT
+};
+
+// One entry of the event log
+struct TraceEvent {
+  TraceOp op;
+  const void *container; //address of the container, to tell them apart
+  long long time_ns;     //0 without CONTAINER_TRACE_TIMESTAMPS
+};
+
+//EFFECTS: returns the name of op
+inline const char * trace_op_name(TraceOp op) {
+  static const char * const NAMES[TRACE_OP_COUNT] = {
+    "push_front", "push_back", "pop_front", "pop_back", "insert", "erase",
+    "copy", "splice"
+  };
+  return NAMES[op];
+}
+
+
+#ifdef CONTAINER_TRACE
+////////////////////////////////////////////////////////////////////////////////
+// Tracing enabled
+
+struct TraceCounts {
+  //OVERVIEW: number of operations of each kind run by one thread
+  long long count[TRACE_OP_COUNT];
+};
+
+inline TraceCounts & trace_counts() {
+  static thread_local TraceCounts counts;
+  return counts;
+}
+
+#ifdef CONTAINER_TRACE_LOG
+struct TraceLog {
+  //OVERVIEW: the last CONTAINER_TRACE_LOG events of one thread
+  TraceEvent events[CONTAINER_TRACE_LOG];
+  std::size_t next; //total number of events recorded
+};
+
+inline TraceLog & trace_log() {
+  static thread_local TraceLog log;
+  return log;
+}
+#endif
+
+//MODIFIES: the calling thread's counters and log
+//EFFECTS:  records one op on container
+inline void trace_op(TraceOp op, const void *container) {
+  ++trace_counts().count[op];
+#ifdef CONTAINER_TRACE_LOG
+  long long time_ns = 0;
+#ifdef CONTAINER_TRACE_TIMESTAMPS
+  time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  TraceLog &log = trace_log();
+  TraceEvent &e = log.events[log.next++ % CONTAINER_TRACE_LOG];
+  e.op = op;
+  e.container = container;
+  e.time_ns = time_ns;
+#else
+  (void)container;
+#endif
+}
+
+//EFFECTS: returns the number of op recorded so far by the calling thread
+inline long long trace_count(TraceOp op) {
+  return trace_counts().count[op];
+}
+
+//MODIFIES: the calling thread's counters and log
+//EFFECTS:  forgets everything recorded so far
+inline void trace_reset() {
+  for (int i = 0; i < TRACE_OP_COUNT; ++i) {
+    trace_counts().count[i] = 0;
+  }
+#ifdef CONTAINER_TRACE_LOG
+  trace_log().next = 0;
+#endif
+}
+
+//EFFECTS: prints the calling thread's counts, and its log oldest first
+inline void trace_print(std::ostream &os) {
+  for (int i = 0; i < TRACE_OP_COUNT; ++i) {
+    TraceOp op = static_cast<TraceOp>(i);
+    os << trace_op_name(op) << ": " << trace_count(op) << "\n";
+  }
+#ifdef CONTAINER_TRACE_LOG
+  const TraceLog &log = trace_log();
+  std::size_t first = log.next > CONTAINER_TRACE_LOG ?
+                      log.next - CONTAINER_TRACE_LOG : 0;
+  for (std::size_t i = first; i < log.next; ++i) {
+    const TraceEvent &e = log.events[i % CONTAINER_TRACE_LOG];
+    os << "  " << e.time_ns << " " << e.container << " "
+       << trace_op_name(e.op) << "\n";
+  }
+#endif
+}
+
+#else
+////////////////////////////////////////////////////////////////////////////////
+// Tracing disabled: every hook is empty and inlines away
+
+inline void trace_op(TraceOp, const void *) {}
+inline long long trace_count(TraceOp) { return 0; }
+inline void trace_reset() {}
+inline void trace_print(std::ostream &) {}
+
+#endif
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef DOUBLYLINKEDLIST_H
+#define DOUBLYLINKEDLIST_H
+/* DoublyLinkedList.h
+ *
+ * Doubly-linked list with a bidirectional Iterator.  It has the interface of
+ * List in 20_List_with_Iterator.h, plus pop_back(), insert() and erase(),
+ * which all take O(1) time.  An Iterator stays valid until the element it
+ * points to is erased.
+ *
+ * The nodes form a ring through a sentinel that lives inside the list, so
+ * end() is a real position: --end() is the last element, and insert(end(), x)
+ * is push_back(x).
+ */
+
+#include <cassert>  //assert
+#include <memory>   //allocator, allocator_traits
+#include <new>      //placement new
+#include <utility>  //move, forward
+#include "ContainerTrace.h" //trace_op
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// DoublyLinkedList declaration
+template <typename T, typename Alloc = std::allocator<T> >
+class DoublyLinkedList {
+  //OVERVIEW: a doubly-linked list.  Nodes are allocated with Alloc.
+ private:
+  //the links of a node.  The sentinel is a bare Link.
+  struct Link {
+    Link *prev;
+    Link *next;
+  };
+
+  struct Node : Link {
+    //EFFECTS: constructs datum from args, without a copy
+    template <typename... Args>
+    Node(Args&&... args) : datum(std::forward<Args>(args)...) {}
+
+    T datum;
+  };
+
+ public:
+  ////////////////////////////////////////
+  class Iterator {
+    //OVERVIEW: bidirectional Iterator interface to DoublyLinkedList
+   public:
+
+    // create a default Iterator, which points nowhere
+    Iterator() : link_ptr(0) {}
+
+    // get the T at the current Iterator position
+    // REQUIRES: Iterator points to an element
+    T& operator* () const {
+      assert(link_ptr);
+      return static_cast<Node *>(link_ptr)->datum;
+    }
+
+    // return the address of the element at the current position
+    T* operator-> () const {
+      return &**this;
+    }
+
+    // move Iterator to next position (prefix)
+    // REQUIRES: Iterator is not end()
+    Iterator& operator++ () {
+      assert(link_ptr);
+      link_ptr = link_ptr->next;
+      return *this;
+    }
+
+    // move Iterator to next position (postfix)
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp; //Note: returns a copy!  This is how postfix works.
+    }
+
+    // move Iterator to previous position (prefix)
+    // REQUIRES: Iterator is not begin()
+    Iterator& operator-- () {
+      assert(link_ptr);
+      link_ptr = link_ptr->prev;
+      return *this;
+    }
+
+    // move Iterator to previous position (postfix)
+    Iterator operator-- (int) {
+      Iterator tmp(*this);
+      --*this;
+      return tmp;
+    }
+
+    // compare two Iterator objects by their position
+    bool operator!= (Iterator rhs) const {
+      return link_ptr != rhs.link_ptr;
+    }
+
+    // compare two Iterator objects by their position
+    bool operator== (Iterator rhs) const {
+      return link_ptr == rhs.link_ptr;
+    }
+
+   private:
+    Link *link_ptr; //a Node, or the sentinel for end()
+    friend class DoublyLinkedList;
+
+    // construct an Iterator at a specific position
+    explicit Iterator(Link *p) : link_ptr(p) {}
+  };//DoublyLinkedList::Iterator
+
+  //EFFECTS:  returns true if the list is empty
+  bool empty() const;
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the first element in the list
+  T & front() const;
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the last element in the list
+  T & back() const;
+
+  //MODIFIES: this
+  //EFFECTS:  inserts datum into the front of the list
+  void push_front(const T &datum) { emplace_front(datum); }
+  void push_front(T &&datum) { emplace_front(std::move(datum)); }
+
+  //MODIFIES: this
+  //EFFECTS:  inserts datum into the back of the list
+  void push_back(const T &datum) { emplace_back(datum); }
+  void push_back(T &&datum) { emplace_back(std::move(datum)); }
+
+  //MODIFIES: this
+  //EFFECTS:  inserts an element constructed in place from args into the
+  //          front of the list
+  template <typename... Args>
+  void emplace_front(Args&&... args);
+
+  //MODIFIES: this
+  //EFFECTS:  inserts an element constructed in place from args into the
+  //          back of the list
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+
+  //REQUIRES: list is not empty
+  //MODIFIES: this
+  //EFFECTS:  removes the item at the front of the list
+  void pop_front();
+
+  //REQUIRES: list is not empty
+  //MODIFIES: this
+  //EFFECTS:  removes the item at the back of the list
+  void pop_back();
+
+  //REQUIRES: pos is an Iterator of this list, possibly end()
+  //MODIFIES: this
+  //EFFECTS:  inserts datum before pos, returns an Iterator to it
+  Iterator insert(Iterator pos, const T &datum) { return emplace(pos, datum); }
+  Iterator insert(Iterator pos, T &&datum) {
+    return emplace(pos, std::move(datum));
+  }
+
+  //REQUIRES: pos is an Iterator of this list, possibly end()
+  //MODIFIES: this
+  //EFFECTS:  inserts an element constructed in place from args before pos,
+  //          returns an Iterator to it
+  template <typename... Args>
+  Iterator emplace(Iterator pos, Args&&... args);
+
+  //REQUIRES: pos points to an element of this list
+  //MODIFIES: this
+  //EFFECTS:  removes the element at pos, returns an Iterator to the element
+  //          that followed it.  Other Iterators stay valid.
+  Iterator erase(Iterator pos);
+
+  // return an Iterator pointing to the first element
+  Iterator begin() const {
+    return Iterator(sentinel.next);
+  }
+
+  // return an Iterator pointing to "past the end"
+  Iterator end() const {
+    return Iterator(const_cast<Link *>(&sentinel));
+  }
+
+  //default constructor and Big Three
+  DoublyLinkedList();
+  DoublyLinkedList(const DoublyLinkedList &other);
+  ~DoublyLinkedList();
+  DoublyLinkedList & operator=(const DoublyLinkedList &rhs);
+
+  //EFFECTS: creates an empty list that allocates its nodes with alloc_in
+  explicit DoublyLinkedList(const Alloc &alloc_in);
+
+  //MODIFIES: other
+  //EFFECTS:  move constructor takes the nodes of other, leaving it empty
+  DoublyLinkedList(DoublyLinkedList &&other);
+
+  //MODIFIES: this, rhs
+  //EFFECTS:  move assignment takes the nodes of rhs, leaving it empty
+  DoublyLinkedList & operator=(DoublyLinkedList &&rhs);
+
+ private:
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node>
+    NodeAlloc;
+
+  //REQUIRES: next is the sentinel or a Node of this list
+  //MODIFIES: this
+  //EFFECTS:  links a new Node with datum constructed from args in front of
+  //          next, and returns it
+  template <typename... Args>
+  Node * create_before(Link *next, Args&&... args);
+
+  //REQUIRES: p is a Node of this list
+  //MODIFIES: this
+  //EFFECTS:  unlinks and destroys p, returns the Link that followed it
+  Link * destroy(Link *p);
+
+  //MODIFIES: this
+  //EFFECTS:  copies all elements from other to the back of this
+  void push_all(const DoublyLinkedList &other);
+
+  //MODIFIES: this
+  //EFFECTS:  removes all elements
+  void pop_all();
+
+  //MODIFIES: this, other
+  //EFFECTS:  moves the nodes of other into this, which must be empty
+  void steal(DoublyLinkedList &other);
+
+  Link sentinel;        //prev is the last Node, next the first; itself if empty
+  NodeAlloc node_alloc; //source of Node memory
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// DoublyLinkedList implementation
+
+template <typename T, typename Alloc>
+bool DoublyLinkedList<T, Alloc>::empty() const {
+  return sentinel.next == &sentinel;
+}
+
+template <typename T, typename Alloc>
+T & DoublyLinkedList<T, Alloc>::front() const {
+  assert(!empty());
+  return static_cast<Node *>(sentinel.next)->datum;
+}
+
+template <typename T, typename Alloc>
+T & DoublyLinkedList<T, Alloc>::back() const {
+  assert(!empty());
+  return static_cast<Node *>(sentinel.prev)->datum;
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+typename DoublyLinkedList<T, Alloc>::Node *
+DoublyLinkedList<T, Alloc>::create_before(Link *next, Args&&... args) {
+  Node *p = node_alloc.allocate(1);
+  try {
+    new (p) Node(std::forward<Args>(args)...);
+  } catch (...) {
+    node_alloc.deallocate(p, 1);
+    throw;
+  }
+  p->prev = next->prev;
+  p->next = next;
+  next->prev->next = p;
+  next->prev = p;
+  return p;
+}
+
+template <typename T, typename Alloc>
+typename DoublyLinkedList<T, Alloc>::Link *
+DoublyLinkedList<T, Alloc>::destroy(Link *p) {
+  assert(p != &sentinel);
+  Link *next = p->next;
+  p->prev->next = next;
+  next->prev = p->prev;
+  Node *victim = static_cast<Node *>(p);
+  victim->~Node();
+  node_alloc.deallocate(victim, 1);
+  return next;
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+void DoublyLinkedList<T, Alloc>::emplace_front(Args&&... args) {
+  create_before(sentinel.next, std::forward<Args>(args)...);
+  trace_op(TRACE_PUSH_FRONT, this);
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+void DoublyLinkedList<T, Alloc>::emplace_back(Args&&... args) {
+  create_before(&sentinel, std::forward<Args>(args)...);
+  trace_op(TRACE_PUSH_BACK, this);
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+typename DoublyLinkedList<T, Alloc>::Iterator
+DoublyLinkedList<T, Alloc>::emplace(Iterator pos, Args&&... args) {
+  assert(pos.link_ptr);
+  Node *p = create_before(pos.link_ptr, std::forward<Args>(args)...);
+  trace_op(TRACE_INSERT, this);
+  return Iterator(p);
+}
+
+template <typename T, typename Alloc>
+typename DoublyLinkedList<T, Alloc>::Iterator
+DoublyLinkedList<T, Alloc>::erase(Iterator pos) {
+  assert(pos.link_ptr);
+  Link *next = destroy(pos.link_ptr);
+  trace_op(TRACE_ERASE, this);
+  return Iterator(next);
+}
+
+template <typename T, typename Alloc>
+void DoublyLinkedList<T, Alloc>::pop_front() {
+  assert(!empty());
+  destroy(sentinel.next);
+  trace_op(TRACE_POP_FRONT, this);
+}
+
+template <typename T, typename Alloc>
+void DoublyLinkedList<T, Alloc>::pop_back() {
+  assert(!empty());
+  destroy(sentinel.prev);
+  trace_op(TRACE_POP_BACK, this);
+}
+
+template <typename T, typename Alloc>
+void DoublyLinkedList<T, Alloc>::pop_all() {
+  while (!empty()) {
+    pop_front();
+  }
+}
+
+template <typename T, typename Alloc>
+void DoublyLinkedList<T, Alloc>::push_all(const DoublyLinkedList &other) {
+  trace_op(TRACE_COPY, this);
+  for (Iterator i = other.begin(); i != other.end(); ++i) {
+    push_back(*i);
+  }
+}
+
+template <typename T, typename Alloc>
+void DoublyLinkedList<T, Alloc>::steal(DoublyLinkedList &other) {
+  assert(empty());
+  if (other.empty()) return;
+  // the end nodes point at other's sentinel, so repoint them at ours
+  sentinel = other.sentinel;
+  sentinel.next->prev = &sentinel;
+  sentinel.prev->next = &sentinel;
+  other.sentinel.prev = other.sentinel.next = &other.sentinel;
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc>::DoublyLinkedList() {
+  sentinel.prev = sentinel.next = &sentinel;
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc>::DoublyLinkedList(const Alloc &alloc_in)
+  : node_alloc(alloc_in) {
+  sentinel.prev = sentinel.next = &sentinel;
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc>::~DoublyLinkedList() {
+  pop_all();
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc>::DoublyLinkedList(const DoublyLinkedList &other)
+  : node_alloc(other.node_alloc) {
+  sentinel.prev = sentinel.next = &sentinel;
+  push_all(other);
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc> &
+DoublyLinkedList<T, Alloc>::operator= (const DoublyLinkedList &rhs) {
+  if (this == &rhs) return *this;
+  pop_all();
+  push_all(rhs);
+  return *this;
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc>::DoublyLinkedList(DoublyLinkedList &&other)
+  : node_alloc(other.node_alloc) {
+  sentinel.prev = sentinel.next = &sentinel;
+  steal(other);
+}
+
+template <typename T, typename Alloc>
+DoublyLinkedList<T, Alloc> &
+DoublyLinkedList<T, Alloc>::operator= (DoublyLinkedList &&rhs) {
+  if (this == &rhs) return *this;
+  pop_all();
+  // the nodes must later go back to the allocator they came from
+  node_alloc = rhs.node_alloc;
+  steal(rhs);
+  return *this;
+}
+
+#endif
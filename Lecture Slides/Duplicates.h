@@ -0,0 +1,182 @@
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+/* Duplicates.h
+ *
+ * Linear-time duplicate detection over any Iterator range, e.g. from
+ * List<T>, UnrolledList<T> or DoublyLinkedList<T>.  no_duplicates() in
+ * 20_Iterators.cpp compares every pair of elements, O(n^2).  These
+ * functions remember the elements seen so far in a hash set instead, O(n)
+ * on average.
+ *
+ * Short ranges of integers (up to DUPLICATES_SMALL_RANGE elements) skip
+ * the hash set.  They are copied to an array and checked with a pairwise
+ * scan written so that the compiler can use vector instructions.
+ *
+ * T must have operator== and a hash function, std::hash<T> by default.
+ */
+
+#include <cstddef>       //size_t
+#include <functional>    //hash
+#include <type_traits>   //decay, is_integral
+#include <unordered_set> //unordered_set
+#include <vector>        //vector
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+// ranges of integers up to this long are checked without a hash set
+static const int DUPLICATES_SMALL_RANGE = 64;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Interface
+
+//EFFECTS: returns an Iterator to the first element in [begin, end) that is
+//         equal to an element before it, or end if all elements differ
+template <typename Iterator>
+Iterator first_duplicate(Iterator begin, Iterator end);
+
+template <typename Iterator, typename Hash>
+Iterator first_duplicate(Iterator begin, Iterator end, Hash hash);
+
+//EFFECTS: returns Iterators to every element in [begin, end) that is equal
+//         to an element before it, in order.  Erasing them leaves one copy
+//         of each value: the first.
+template <typename Iterator>
+std::vector<Iterator> all_duplicates(Iterator begin, Iterator end);
+
+template <typename Iterator, typename Hash>
+std::vector<Iterator> all_duplicates(Iterator begin, Iterator end, Hash hash);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+
+// Hash set entries point at the elements, so nothing is copied.  The
+// elements must stay put while the range is scanned, which they do in a
+// linked list.
+template <typename T, typename Hash>
+struct DuplicatesHashPtr {
+  Hash hash;
+  explicit DuplicatesHashPtr(const Hash &hash_in) : hash(hash_in) {}
+  std::size_t operator() (const T *p) const { return hash(*p); }
+};
+
+template <typename T>
+struct DuplicatesEqualPtr {
+  bool operator() (const T *a, const T *b) const { return *a == *b; }
+};
+
+//REQUIRES: a has DUPLICATES_SMALL_RANGE initialized elements, and
+//          0 <= n <= DUPLICATES_SMALL_RANGE
+//MODIFIES: is_dup
+//EFFECTS:  sets is_dup[i] to whether a[i] equals some a[j], j < i < n.
+//          Stops after the first duplicate if first_only.
+template <typename T>
+void mark_duplicates_small(const T a[], int n, bool is_dup[], bool first_only) {
+  static_assert(DUPLICATES_SMALL_RANGE % 8 == 0, "scan reads blocks of 8");
+  for (int i = 0; i < n; ++i) is_dup[i] = false;
+  for (int i = 1; i < n; ++i) {
+    // Compare x with a[0..i) eight at a time.  The inner loop has a fixed
+    // length and no early exit, so g++ -O2 compiles it to vector compares.
+    // Slots at i and beyond are masked off.
+    const T x = a[i];
+    int found = 0;
+    for (int block = 0; block < i; block += 8) {
+      for (int j = 0; j < 8; ++j) {
+        found |= (a[block + j] == x) & (block + j < i);
+      }
+    }
+    is_dup[i] = found;
+    if (found && first_only) return;
+  }
+}
+
+//MODIFIES: dups
+//EFFECTS:  returns the first duplicate in [begin, end), or end if there is
+//          none.  If dups is not 0, keeps going and appends every duplicate
+//          to it.  This version is for integers: a short range goes through
+//          mark_duplicates_small().
+template <typename Iterator, typename Hash>
+Iterator find_duplicates(Iterator begin, Iterator end, Hash hash,
+                         std::vector<Iterator> *dups, std::true_type) {
+  typedef typename std::decay<decltype(*begin)>::type T;
+  T values[DUPLICATES_SMALL_RANGE] = {}; //scanned in blocks past n
+  Iterator where[DUPLICATES_SMALL_RANGE];
+  int n = 0;
+  Iterator i = begin;
+  for (; i != end && n < DUPLICATES_SMALL_RANGE; ++i, ++n) {
+    values[n] = *i;
+    where[n] = i;
+  }
+  if (i == end) {
+    bool is_dup[DUPLICATES_SMALL_RANGE];
+    mark_duplicates_small(values, n, is_dup, dups == 0);
+    Iterator first = end;
+    for (int k = 0; k < n; ++k) {
+      if (!is_dup[k]) continue;
+      if (first == end) first = where[k];
+      if (!dups) break;
+      dups->push_back(where[k]);
+    }
+    return first;
+  }
+
+  // too long: start over with a hash set of values
+  std::unordered_set<T, Hash> seen(4 * DUPLICATES_SMALL_RANGE, hash);
+  Iterator first = end;
+  for (i = begin; i != end; ++i) {
+    if (seen.insert(*i).second) continue;
+    if (first == end) first = i;
+    if (!dups) break;
+    dups->push_back(i);
+  }
+  return first;
+}
+
+//MODIFIES: dups
+//EFFECTS:  like above, for any other T
+template <typename Iterator, typename Hash>
+Iterator find_duplicates(Iterator begin, Iterator end, Hash hash,
+                         std::vector<Iterator> *dups, std::false_type) {
+  typedef typename std::decay<decltype(*begin)>::type T;
+  std::unordered_set<const T *, DuplicatesHashPtr<T, Hash>,
+                     DuplicatesEqualPtr<T> >
+    seen(4 * DUPLICATES_SMALL_RANGE, DuplicatesHashPtr<T, Hash>(hash));
+  Iterator first = end;
+  for (Iterator i = begin; i != end; ++i) {
+    if (seen.insert(&*i).second) continue;
+    if (first == end) first = i;
+    if (!dups) break;
+    dups->push_back(i);
+  }
+  return first;
+}
+
+template <typename Iterator, typename Hash>
+Iterator first_duplicate(Iterator begin, Iterator end, Hash hash) {
+  typedef typename std::decay<decltype(*begin)>::type T;
+  std::vector<Iterator> *no_list = 0;
+  return find_duplicates(begin, end, hash, no_list, std::is_integral<T>());
+}
+
+template <typename Iterator>
+Iterator first_duplicate(Iterator begin, Iterator end) {
+  typedef typename std::decay<decltype(*begin)>::type T;
+  return first_duplicate(begin, end, std::hash<T>());
+}
+
+template <typename Iterator, typename Hash>
+std::vector<Iterator> all_duplicates(Iterator begin, Iterator end, Hash hash) {
+  typedef typename std::decay<decltype(*begin)>::type T;
+  std::vector<Iterator> dups;
+  find_duplicates(begin, end, hash, &dups, std::is_integral<T>());
+  return dups;
+}
+
+template <typename Iterator>
+std::vector<Iterator> all_duplicates(Iterator begin, Iterator end) {
+  typedef typename std::decay<decltype(*begin)>::type T;
+  return all_duplicates(begin, end, std::hash<T>());
+}
+
+#endif
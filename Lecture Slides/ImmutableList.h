@@ -0,0 +1,307 @@
+#ifndef IMMUTABLELIST_H
+#define IMMUTABLELIST_H
+/* ImmutableList.h
+ *
+ * Persistent singly-linked list.  Its elements never change once it is
+ * built.  push_front() and pop_front() don't modify the list; they return a
+ * new one that shares all the old nodes:
+ *
+ *   ImmutableList<int> a;
+ *   ImmutableList<int> b = a.push_front(1);  //b = (1)
+ *   ImmutableList<int> c = b.push_front(2);  //c = (2 1), shares the 1 with b
+ *   ImmutableList<int> d = c.pop_front();    //d = (1), b is unchanged
+ *
+ * Since nothing is ever modified, a copy doesn't copy anything: it is one
+ * more reference to the same nodes.  Copying, push_front() and pop_front()
+ * all take O(1) time.  Each node counts the lists and nodes that point to
+ * it, and is destroyed with the last one.
+ *
+ * The counts are atomic, so different ImmutableList objects that share
+ * nodes can be used, copied and destroyed by different threads at once.  A
+ * thread can take a snapshot of a list by copying it, then read it while
+ * other threads go on building new lists.  As with any object, a single
+ * ImmutableList variable must not be assigned by one thread while another
+ * reads it.
+ */
+
+#include <atomic>   //atomic
+#include <cassert>  //assert
+#include <memory>   //allocator, allocator_traits
+#include <new>      //placement new
+#include <utility>  //move, forward
+#include "ContainerTrace.h" //trace_op
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ImmutableList declaration
+template <typename T, typename Alloc = std::allocator<T> >
+class ImmutableList {
+  //OVERVIEW: a persistent, singly-linked list whose nodes are shared by
+  //          reference counting.  Nodes are allocated with Alloc.
+ private:
+  struct Node {
+    //EFFECTS: constructs datum from args, without a copy.  The new node is
+    //         referenced once, by the list it is created for.
+    template <typename... Args>
+    Node(Node *next_in, Args&&... args)
+      : refs(1), next(next_in), datum(std::forward<Args>(args)...) {}
+
+    std::atomic<long> refs; //lists and nodes that point here
+    Node *next;             //owns one reference to next
+    const T datum;
+  };
+
+ public:
+  ////////////////////////////////////////
+  class Iterator {
+    //OVERVIEW: Iterator interface to ImmutableList.  It doesn't hold a
+    //          reference, so the list must outlive it.
+   public:
+
+    // create a default Iterator, which points nowhere
+    Iterator() : node_ptr(0) {}
+
+    // get the T at the current Iterator position
+    // REQUIRES: Iterator points to an element
+    const T& operator* () const {
+      assert(node_ptr);
+      return node_ptr->datum;
+    }
+
+    // return the address of the element at the current position
+    const T* operator-> () const {
+      return &**this;
+    }
+
+    // move Iterator to next position (prefix)
+    Iterator& operator++ () {
+      assert(node_ptr);
+      node_ptr = node_ptr->next;
+      return *this;
+    }
+
+    // move Iterator to next position (postfix)
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp; //Note: returns a copy!  This is how postfix works.
+    }
+
+    // compare two Iterator objects by their position
+    bool operator!= (Iterator rhs) const {
+      return node_ptr != rhs.node_ptr;
+    }
+
+    // compare two Iterator objects by their position
+    bool operator== (Iterator rhs) const {
+      return node_ptr == rhs.node_ptr;
+    }
+
+   private:
+    const Node *node_ptr; //current Iterator position is a List node
+    friend class ImmutableList;
+
+    // construct an Iterator at a specific position
+    explicit Iterator(const Node *p) : node_ptr(p) {}
+  };//ImmutableList::Iterator
+
+  // elements can't be changed through any Iterator
+  typedef Iterator ConstIterator;
+
+  //EFFECTS:  returns true if the list is empty
+  bool empty() const { return first == 0; }
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the first element in the list
+  const T & front() const;
+
+  //EFFECTS: returns a list of datum followed by the elements of this
+  ImmutableList push_front(const T &datum) const;
+  ImmutableList push_front(T &&datum) const;
+
+  //EFFECTS: returns a list of an element constructed in place from args,
+  //         followed by the elements of this
+  template <typename... Args>
+  ImmutableList emplace_front(Args&&... args) const;
+
+  //REQUIRES: list is not empty
+  //EFFECTS:  returns a list of the elements of this except the first
+  ImmutableList pop_front() const;
+
+  //EFFECTS: returns true if this and other share their first node, which
+  //         means that they hold the same elements
+  bool same_as(const ImmutableList &other) const {
+    return first == other.first;
+  }
+
+  // return an Iterator pointing to the first element
+  Iterator begin() const {
+    return Iterator(first);
+  }
+
+  // return an Iterator pointing to "past the end"
+  Iterator end() const {
+    return Iterator();
+  }
+
+  //default constructor and Big Three.  Copies share the nodes of the
+  //original, so they take O(1) time.
+  ImmutableList();
+  ImmutableList(const ImmutableList &other);
+  ~ImmutableList();
+  ImmutableList & operator=(const ImmutableList &rhs);
+
+  //EFFECTS: creates an empty list that allocates its nodes with alloc_in
+  explicit ImmutableList(const Alloc &alloc_in);
+
+  //MODIFIES: other
+  //EFFECTS:  move constructor takes the nodes of other, leaving it empty
+  ImmutableList(ImmutableList &&other);
+
+  //MODIFIES: this, rhs
+  //EFFECTS:  move assignment takes the nodes of rhs, leaving it empty
+  ImmutableList & operator=(ImmutableList &&rhs);
+
+ private:
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node>
+    NodeAlloc;
+
+  //EFFECTS: creates a list that takes over one reference to first_in
+  ImmutableList(Node *first_in, const NodeAlloc &alloc_in);
+
+  //REQUIRES: p is 0 or a Node that is referenced at least once
+  //MODIFIES: p
+  //EFFECTS:  adds a reference to p, and returns p
+  static Node * retain(Node *p);
+
+  //REQUIRES: p is 0 or a Node that this holds a reference to
+  //MODIFIES: p and the nodes after it
+  //EFFECTS:  drops that reference.  Destroys p if no one else refers to it,
+  //          then drops its reference to the next node in turn.
+  void release(Node *p);
+
+  Node *first;          //0 if empty; owns one reference
+  NodeAlloc node_alloc; //source of Node memory
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ImmutableList implementation
+
+template <typename T, typename Alloc>
+const T & ImmutableList<T, Alloc>::front() const {
+  assert(!empty());
+  return first->datum;
+}
+
+template <typename T, typename Alloc>
+typename ImmutableList<T, Alloc>::Node *
+ImmutableList<T, Alloc>::retain(Node *p) {
+  // Only a thread that already holds a reference can add one, so the count
+  // can't reach zero meanwhile and no ordering is needed.
+  if (p) p->refs.fetch_add(1, std::memory_order_relaxed);
+  return p;
+}
+
+template <typename T, typename Alloc>
+void ImmutableList<T, Alloc>::release(Node *p) {
+  // A loop rather than recursion, so that dropping a long list can't
+  // overflow the stack.  The acq_rel decrement makes the last owner see
+  // everything the other owners did before they let go.
+  while (p && p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    Node *next = p->next;
+    p->~Node();
+    node_alloc.deallocate(p, 1);
+    p = next;
+  }
+}
+
+template <typename T, typename Alloc>
+template <typename... Args>
+ImmutableList<T, Alloc>
+ImmutableList<T, Alloc>::emplace_front(Args&&... args) const {
+  NodeAlloc alloc(node_alloc);
+  Node *p = alloc.allocate(1);
+  try {
+    new (p) Node(first, std::forward<Args>(args)...);
+  } catch (...) {
+    alloc.deallocate(p, 1);
+    throw;
+  }
+  retain(first); //for p->next
+  trace_op(TRACE_PUSH_FRONT, this);
+  return ImmutableList(p, alloc);
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>
+ImmutableList<T, Alloc>::push_front(const T &datum) const {
+  return emplace_front(datum);
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>
+ImmutableList<T, Alloc>::push_front(T &&datum) const {
+  return emplace_front(std::move(datum));
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc> ImmutableList<T, Alloc>::pop_front() const {
+  assert(!empty());
+  trace_op(TRACE_POP_FRONT, this);
+  return ImmutableList(retain(first->next), node_alloc);
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>::ImmutableList() : first(0) {}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>::ImmutableList(const Alloc &alloc_in)
+  : first(0), node_alloc(alloc_in) {}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>::ImmutableList(Node *first_in,
+                                       const NodeAlloc &alloc_in)
+  : first(first_in), node_alloc(alloc_in) {}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>::~ImmutableList() {
+  release(first);
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>::ImmutableList(const ImmutableList &other)
+  : first(retain(other.first)), node_alloc(other.node_alloc) {}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc> &
+ImmutableList<T, Alloc>::operator= (const ImmutableList &rhs) {
+  // retain first, in case rhs shares nodes that release() would destroy
+  Node *p = retain(rhs.first);
+  release(first);
+  first = p;
+  // the nodes must later go back to the allocator they came from
+  node_alloc = rhs.node_alloc;
+  return *this;
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc>::ImmutableList(ImmutableList &&other)
+  : first(other.first), node_alloc(other.node_alloc) {
+  other.first = 0;
+}
+
+template <typename T, typename Alloc>
+ImmutableList<T, Alloc> &
+ImmutableList<T, Alloc>::operator= (ImmutableList &&rhs) {
+  if (this == &rhs) return *this;
+  release(first);
+  first = rhs.first;
+  node_alloc = rhs.node_alloc;
+  rhs.first = 0;
+  return *this;
+}
+
+#endif
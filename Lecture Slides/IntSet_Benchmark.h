@@ -0,0 +1,370 @@
+#ifndef INTSET_BENCHMARK_H
+#define INTSET_BENCHMARK_H
+/* IntSet_Benchmark.h
+ *
+ * Benchmark harness for the IntSet implementations.  Drives any type with
+ * insert(), remove() and query() through a workload and prints one JSON
+ * result per line.  Pass an IntSet & to measure calls through the abstract
+ * interface.
+ *
+ * A workload is an operation mix, a key distribution and a size.  Keys are
+ * drawn from [0, size), so a set never holds more than size elements.
+ *
+ *   --mix=read|write|churn|miss      operation mix (default: all)
+ *   --dist=uniform|sequential|zipf   key distribution (default: all)
+ *   --size=N                         key range (default: several)
+ *   --ops=N                          timed operations per run
+ *   --seed=N                         random seed
+ */
+
+#include "Benchmark.h"
+#include <algorithm> //shuffle
+#include <cmath>     //pow
+#include <cstdlib>   //exit, atoi
+#include <iostream>  //cerr
+#include <random>    //mt19937, distributions
+#include <string>    //string
+#include <vector>    //vector
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Workloads
+
+enum OpMix {
+  READ_HEAVY,  //90% query, 5% insert, 5% remove
+  WRITE_HEAVY, //20% query, 40% insert, 40% remove
+  CHURN,       //remove a member then insert a non-member, size stays fixed
+  MISS_HEAVY   //100% query against a set that holds a tenth of the keys
+};
+
+enum KeyDistribution { UNIFORM, SEQUENTIAL, ZIPFIAN };
+
+enum OpType { OP_QUERY, OP_INSERT, OP_REMOVE };
+
+struct IntSetOp {
+  OpType type;
+  int key;
+};
+
+struct IntSetWorkload {
+  OpMix mix;
+  KeyDistribution dist;
+  int size;      //keys are drawn from [0, size)
+  int ops;       //number of timed operations
+  unsigned seed;
+};
+
+//EFFECTS: returns the command line name of mix or dist
+inline const char * name_of(OpMix mix) {
+  const char *names[] = {"read", "write", "churn", "miss"};
+  return names[mix];
+}
+
+inline const char * name_of(KeyDistribution dist) {
+  const char *names[] = {"uniform", "sequential", "zipf"};
+  return names[dist];
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+class KeyGenerator {
+  //OVERVIEW: draws keys in [0, size) from a distribution
+ public:
+
+  //REQUIRES: size > 0
+  KeyGenerator(KeyDistribution dist_in, int size_in, std::mt19937 &rng_in)
+    : dist(dist_in), size(size_in), next_key(0), rng(rng_in),
+      uniform(0, size_in - 1) {
+    if (dist == ZIPFIAN) {
+      // rank r is drawn with weight 1/(r+1)^s; ranks map to random keys so
+      // that the hot keys are spread over the whole range
+      const double s = 0.99;
+      std::vector<double> weights(size);
+      for (int r = 0; r < size; ++r) weights[r] = 1 / std::pow(r + 1.0, s);
+      zipf = std::discrete_distribution<int>(weights.begin(), weights.end());
+      for (int k = 0; k < size; ++k) key_of_rank.push_back(k);
+      std::shuffle(key_of_rank.begin(), key_of_rank.end(), rng);
+    }
+  }
+
+  //MODIFIES: this
+  //EFFECTS:  returns the next key
+  int next() {
+    switch (dist) {
+    case UNIFORM:    return uniform(rng);
+    case SEQUENTIAL: return next_key++ % size;
+    case ZIPFIAN:    return key_of_rank[zipf(rng)];
+    }
+    return 0;
+  }
+
+ private:
+  KeyDistribution dist;
+  int size;
+  int next_key;
+  std::mt19937 &rng;
+  std::uniform_int_distribution<int> uniform;
+  std::discrete_distribution<int> zipf;
+  std::vector<int> key_of_rank;
+};
+
+
+//MODIFIES: prefill, ops
+//EFFECTS: fills prefill with the keys to insert before timing (half of the
+//         key range, a tenth for MISS_HEAVY) and ops with the timed
+//         operations of workload w
+inline void make_trace(const IntSetWorkload &w,
+                       std::vector<int> &prefill, std::vector<IntSetOp> &ops) {
+  std::mt19937 rng(w.seed);
+  KeyGenerator keys(w.dist, w.size, rng);
+
+  std::vector<int> all;
+  for (int k = 0; k < w.size; ++k) all.push_back(k);
+  std::shuffle(all.begin(), all.end(), rng);
+  int members = (w.mix == MISS_HEAVY) ? (w.size + 9) / 10 : w.size / 2;
+  prefill.assign(all.begin(), all.begin() + members);
+
+  // track membership so that churn always removes a member and inserts a
+  // non-member
+  std::vector<char> present(w.size, 0);
+  for (std::size_t i = 0; i < prefill.size(); ++i) present[prefill[i]] = 1;
+
+  std::uniform_int_distribution<int> percent(0, 99);
+  ops.clear();
+  while (static_cast<int>(ops.size()) < w.ops) {
+    int key = keys.next();
+    IntSetOp op = {OP_QUERY, key};
+
+    if (w.mix == CHURN) {
+      // probe forward from the drawn key to the nearest member to remove,
+      // then to the nearest non-member to insert
+      int victim = key;
+      while (!present[victim]) victim = (victim + 1) % w.size;
+      int fresh = keys.next();
+      while (present[fresh] && fresh != victim) fresh = (fresh + 1) % w.size;
+      IntSetOp remove_op = {OP_REMOVE, victim};
+      IntSetOp insert_op = {OP_INSERT, fresh};
+      ops.push_back(remove_op);
+      ops.push_back(insert_op);
+      present[victim] = 0;
+      present[fresh] = 1;
+      continue;
+    }
+
+    int p = percent(rng);
+    int query_percent = 20;
+    if (w.mix == READ_HEAVY) query_percent = 90;
+    if (w.mix == MISS_HEAVY) query_percent = 100;
+    if (p >= query_percent) {
+      op.type = (p - query_percent) % 2 ? OP_REMOVE : OP_INSERT;
+    }
+    if (op.type != OP_QUERY) {
+      // remove REQUIRES a member, so probe forward to the nearest one.
+      // Likewise probe inserts to a non-member, otherwise the set would
+      // drift towards empty.
+      char wanted = (op.type == OP_REMOVE);
+      int probes = 0;
+      while (present[op.key] != wanted && probes++ < w.size)
+        op.key = (op.key + 1) % w.size;
+      if (present[op.key] != wanted) op.type = OP_QUERY; //empty or full
+    }
+    if (op.type == OP_INSERT) present[op.key] = 1;
+    if (op.type == OP_REMOVE) present[op.key] = 0;
+    ops.push_back(op);
+  }
+  ops.resize(w.ops);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Harness
+
+//REQUIRES: set is empty and can hold w.size elements
+//MODIFIES: set, os
+//EFFECTS: runs workload w against set and prints one JSON result to os.
+//         Latency percentiles are per operation, measured over batches of
+//         BATCH operations because a clock read costs about as much as a
+//         query.  set is empty again on return.  query() is only called
+//         for the queries of w, so statistics that set keeps about them
+//         cover those alone.
+template <typename Set>
+void benchmark_IntSet(std::ostream &os, const std::string &impl, Set &set,
+                      const IntSetWorkload &w) {
+  const int BATCH = 64;
+  std::vector<int> prefill;
+  std::vector<IntSetOp> ops;
+  make_trace(w, prefill, ops);
+  LatencyRecorder latency(ops.size() / BATCH + 1);
+
+  // the members left at the end, so that they can be removed without
+  // query(), which would add to statistics kept by set, like the false
+  // positives of a BloomIntSet
+  std::vector<char> present(w.size, 0);
+  for (std::size_t i = 0; i < prefill.size(); ++i) present[prefill[i]] = 1;
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    if (ops[i].type == OP_INSERT) present[ops[i].key] = 1;
+    if (ops[i].type == OP_REMOVE) present[ops[i].key] = 0;
+  }
+
+  long long allocs_before = g_alloc_stats.allocs.load();
+  long long frees_before = g_alloc_stats.frees.load();
+  long long live_before = live_bytes();
+  reset_peak_bytes();
+
+  for (std::size_t i = 0; i < prefill.size(); ++i) set.insert(prefill[i]);
+
+  long long hits = 0;
+  long long start = now_ns();
+  for (std::size_t i = 0; i < ops.size(); i += BATCH) {
+    std::size_t end = std::min(ops.size(), i + BATCH);
+    long long batch_start = now_ns();
+    for (std::size_t j = i; j < end; ++j) {
+      const IntSetOp &op = ops[j];
+      switch (op.type) {
+      case OP_QUERY:  hits += set.query(op.key); break;
+      case OP_INSERT: set.insert(op.key);        break;
+      case OP_REMOVE: set.remove(op.key);        break;
+      }
+    }
+    latency.add(double(now_ns() - batch_start) / (end - i));
+  }
+  long long elapsed = now_ns() - start;
+  int final_size = set.size();
+
+  for (int k = 0; k < w.size; ++k) {
+    if (present[k]) set.remove(k);
+  }
+
+  // read the counters before building the row, which allocates
+  long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+  long long frees = g_alloc_stats.frees.load() - frees_before;
+  long long peak_heap = g_alloc_stats.peak_bytes.load() - live_before;
+
+  BenchmarkRow row;
+  row.add("impl", impl)
+     .add("mix", name_of(w.mix))
+     .add("dist", name_of(w.dist))
+     .add("size", w.size)
+     .add("ops", w.ops)
+     .add("ns_per_op", double(elapsed) / w.ops)
+     .add("p50_ns", latency.percentile(50))
+     .add("p90_ns", latency.percentile(90))
+     .add("p99_ns", latency.percentile(99))
+     .add("max_ns", latency.percentile(100))
+     .add("allocs", allocs)
+     .add("frees", frees)
+     .add("peak_heap_bytes", peak_heap)
+     .add("peak_rss_kb", static_cast<long long>(peak_rss_kb()))
+     .add("final_size", final_size)
+     .add("hits", hits);
+  row.print(os);
+}
+
+
+//REQUIRES: set is empty and can hold w.size elements
+//MODIFIES: set, os
+//EFFECTS: fills half of set, then times w.ops calls to query() with keys
+//         from w.dist in a tight loop and prints one JSON result to os, with
+//         "query_loop" as the mix.  Use this to compare the cost of the call
+//         itself, e.g. virtual against inlined.  set is empty again on return.
+template <typename Set>
+void benchmark_IntSet_queries(std::ostream &os, const std::string &impl,
+                              Set &set, const IntSetWorkload &w) {
+  std::vector<int> prefill;
+  std::vector<IntSetOp> unused;
+  IntSetWorkload fill = w;
+  fill.ops = 0;
+  make_trace(fill, prefill, unused);
+
+  std::mt19937 rng(w.seed);
+  KeyGenerator generator(w.dist, w.size, rng);
+  std::vector<int> keys(w.ops);
+  for (int i = 0; i < w.ops; ++i) keys[i] = generator.next();
+
+  for (std::size_t i = 0; i < prefill.size(); ++i) set.insert(prefill[i]);
+
+  long long hits = 0;
+  long long start = now_ns();
+  for (int i = 0; i < w.ops; ++i) {
+    hits += set.query(keys[i]);
+  }
+  long long elapsed = now_ns() - start;
+
+  for (std::size_t i = 0; i < prefill.size(); ++i) set.remove(prefill[i]);
+
+  BenchmarkRow row;
+  row.add("impl", impl)
+     .add("mix", "query_loop")
+     .add("dist", name_of(w.dist))
+     .add("size", w.size)
+     .add("ops", w.ops)
+     .add("ns_per_op", double(elapsed) / w.ops)
+     .add("hits", hits);
+  row.print(os);
+}
+
+
+//EFFECTS: returns the workloads selected on the command line.  Options that
+//         are not given expand to every mix, every distribution and each of
+//         default_sizes.  Exits with a message on bad options, including a
+//         size larger than max_size.
+inline std::vector<IntSetWorkload> IntSet_workloads(
+  int argc, char *argv[], const std::vector<int> &default_sizes, int max_size) {
+  std::vector<OpMix> mixes;
+  std::vector<KeyDistribution> dists;
+  std::vector<int> sizes;
+  int ops = 200000;
+  unsigned seed = 280;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value = arg.substr(arg.find('=') + 1);
+    if (arg == "--mix=read")              mixes.push_back(READ_HEAVY);
+    else if (arg == "--mix=write")        mixes.push_back(WRITE_HEAVY);
+    else if (arg == "--mix=churn")        mixes.push_back(CHURN);
+    else if (arg == "--mix=miss")         mixes.push_back(MISS_HEAVY);
+    else if (arg == "--dist=uniform")     dists.push_back(UNIFORM);
+    else if (arg == "--dist=sequential")  dists.push_back(SEQUENTIAL);
+    else if (arg == "--dist=zipf")        dists.push_back(ZIPFIAN);
+    else if (arg.compare(0, 7, "--size=") == 0)
+      sizes.push_back(std::atoi(value.c_str()));
+    else if (arg.compare(0, 6, "--ops=") == 0)
+      ops = std::atoi(value.c_str());
+    else if (arg.compare(0, 7, "--seed=") == 0)
+      seed = std::atoi(value.c_str());
+    else {
+      std::cerr << "Unrecognized option `" << arg << "'\n";
+      std::exit(1);
+    }
+  }
+
+  if (mixes.empty()) {
+    mixes.push_back(READ_HEAVY);
+    mixes.push_back(WRITE_HEAVY);
+    mixes.push_back(CHURN);
+    mixes.push_back(MISS_HEAVY);
+  }
+  if (dists.empty()) {
+    dists.push_back(UNIFORM);
+    dists.push_back(SEQUENTIAL);
+    dists.push_back(ZIPFIAN);
+  }
+  if (sizes.empty()) sizes = default_sizes;
+
+  std::vector<IntSetWorkload> workloads;
+  for (std::size_t s = 0; s < sizes.size(); ++s) {
+    if (sizes[s] < 2 || sizes[s] > max_size || ops <= 0) {
+      std::cerr << "size must be in [2, " << max_size << "] and ops > 0\n";
+      std::exit(1);
+    }
+    for (std::size_t m = 0; m < mixes.size(); ++m) {
+      for (std::size_t d = 0; d < dists.size(); ++d) {
+        IntSetWorkload w = {mixes[m], dists[d], sizes[s], ops, seed};
+        workloads.push_back(w);
+      }
+    }
+  }
+  return workloads;
+}
+
+#endif
@@ -0,0 +1,349 @@
+#ifndef INTRUSIVELIST_H
+#define INTRUSIVELIST_H
+/* IntrusiveList.h
+ *
+ * Intrusive doubly-linked list.  Instead of allocating a Node that points
+ * to an object, the list links the objects themselves: each one derives
+ * from ListHook, which holds its links.
+ *
+ *   class Gorilla : public ListHook { ... };
+ *   IntrusiveList<Gorilla> zoo;
+ *   zoo.push_back(*g);              //no allocation
+ *   g->unlink();                    //O(1), without knowing the list
+ *
+ * Traversal follows one pointer per element, instead of a Node pointer and
+ * then the element pointer as in List<Gorilla*>.  An object can be in only
+ * one IntrusiveList at a time, and it leaves the list when destroyed.
+ *
+ * By default the list doesn't own its elements.  With DeleteDisposer it
+ * deletes each element it removes, and all remaining ones when destroyed.
+ */
+
+#include <cassert>  //assert
+#include "ContainerTrace.h" //trace_op
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ListHook
+class ListHook {
+  //OVERVIEW: the links that put an object into an IntrusiveList
+ public:
+
+  //EFFECTS: creates a hook that is not in any list
+  ListHook() : prev(0), next(0) {}
+
+  //EFFECTS: a copy of an object is not in the original's list
+  ListHook(const ListHook &) : prev(0), next(0) {}
+
+  //EFFECTS: assigning to an object doesn't change which list it is in
+  ListHook & operator= (const ListHook &) { return *this; }
+
+  //EFFECTS: removes this object from its list, if any
+  ~ListHook() { unlink(); }
+
+  //EFFECTS: returns true if this object is in a list
+  bool is_linked() const { return next != 0; }
+
+  //MODIFIES: this, and the list it is in
+  //EFFECTS:  removes this object from its list in O(1) time.  The list
+  //          doesn't dispose of it.  Does nothing if it is in no list.
+  void unlink() {
+    if (!next) return;
+    prev->next = next;
+    next->prev = prev;
+    prev = next = 0;
+  }
+
+ private:
+  ListHook *prev; //0 when not in a list
+  ListHook *next;
+  template <typename T, typename Disposer> friend class IntrusiveList;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Disposers decide what happens to an element removed from the list
+
+struct NoDisposer {
+  template <typename T>
+  void operator() (T *) const {}
+};
+
+struct DeleteDisposer {
+  template <typename T>
+  void operator() (T *p) const { delete p; }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// IntrusiveList declaration
+template <typename T, typename Disposer = NoDisposer>
+class IntrusiveList {
+  //OVERVIEW: a doubly-linked list of T objects, which derive from ListHook.
+  //          Elements are disposed of with Disposer when the list removes
+  //          them; they are not when they unlink() themselves.
+ public:
+
+  ////////////////////////////////////////
+  class Iterator {
+    //OVERVIEW: bidirectional Iterator interface to IntrusiveList
+   public:
+
+    // create a default Iterator, which points nowhere
+    Iterator() : hook_ptr(0) {}
+
+    // get the T at the current Iterator position
+    // REQUIRES: Iterator points to an element
+    T& operator* () const {
+      assert(hook_ptr);
+      return *static_cast<T *>(hook_ptr);
+    }
+
+    // return the address of the element at the current position
+    T* operator-> () const {
+      return &**this;
+    }
+
+    // move Iterator to next position (prefix)
+    Iterator& operator++ () {
+      assert(hook_ptr);
+      hook_ptr = hook_ptr->next;
+      return *this;
+    }
+
+    // move Iterator to next position (postfix)
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp; //Note: returns a copy!  This is how postfix works.
+    }
+
+    // move Iterator to previous position (prefix)
+    Iterator& operator-- () {
+      assert(hook_ptr);
+      hook_ptr = hook_ptr->prev;
+      return *this;
+    }
+
+    // move Iterator to previous position (postfix)
+    Iterator operator-- (int) {
+      Iterator tmp(*this);
+      --*this;
+      return tmp;
+    }
+
+    // compare two Iterator objects by their position
+    bool operator!= (Iterator rhs) const {
+      return hook_ptr != rhs.hook_ptr;
+    }
+
+    // compare two Iterator objects by their position
+    bool operator== (Iterator rhs) const {
+      return hook_ptr == rhs.hook_ptr;
+    }
+
+   private:
+    ListHook *hook_ptr; //an element, or the sentinel for end()
+    friend class IntrusiveList;
+
+    // construct an Iterator at a specific position
+    explicit Iterator(ListHook *p) : hook_ptr(p) {}
+  };//IntrusiveList::Iterator
+
+  //EFFECTS:  returns true if the list is empty
+  bool empty() const { return sentinel.next == &sentinel; }
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the first element in the list
+  T & front() const;
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the last element in the list
+  T & back() const;
+
+  //REQUIRES: obj is not in any list
+  //MODIFIES: this, obj
+  //EFFECTS:  inserts obj into the front of the list
+  void push_front(T &obj);
+
+  //REQUIRES: obj is not in any list
+  //MODIFIES: this, obj
+  //EFFECTS:  inserts obj into the back of the list
+  void push_back(T &obj);
+
+  //REQUIRES: list is not empty
+  //MODIFIES: this
+  //EFFECTS:  removes and disposes of the item at the front of the list
+  void pop_front();
+
+  //REQUIRES: list is not empty
+  //MODIFIES: this
+  //EFFECTS:  removes and disposes of the item at the back of the list
+  void pop_back();
+
+  //REQUIRES: pos is an Iterator of this list, possibly end(), and obj is
+  //          not in any list
+  //MODIFIES: this, obj
+  //EFFECTS:  inserts obj before pos, returns an Iterator to it
+  Iterator insert(Iterator pos, T &obj);
+
+  //REQUIRES: pos points to an element of this list
+  //MODIFIES: this
+  //EFFECTS:  removes and disposes of the element at pos, returns an
+  //          Iterator to the element that followed it
+  Iterator erase(Iterator pos);
+
+  //MODIFIES: this
+  //EFFECTS:  removes and disposes of all elements
+  void clear();
+
+  // return an Iterator pointing to the first element
+  Iterator begin() const {
+    return Iterator(sentinel.next);
+  }
+
+  // return an Iterator pointing to "past the end"
+  Iterator end() const {
+    return Iterator(const_cast<ListHook *>(&sentinel));
+  }
+
+  //EFFECTS: creates an empty list
+  IntrusiveList(Disposer dispose_in = Disposer());
+
+  //MODIFIES: other
+  //EFFECTS:  move constructor takes the elements of other, leaving it empty
+  IntrusiveList(IntrusiveList &&other);
+
+  //EFFECTS: removes and disposes of all elements
+  ~IntrusiveList();
+
+ private:
+  //MODIFIES: this, obj
+  //EFFECTS:  links obj in front of next
+  void link_before(ListHook *next, T &obj);
+
+  //MODIFIES: this
+  //EFFECTS:  unlinks p and disposes of it, returns the hook that followed it
+  ListHook * remove(ListHook *p);
+
+  ListHook sentinel; //prev is the last element, next the first; itself if empty
+  Disposer dispose;
+
+  // elements can be in only one list, so a list can't be copied
+  IntrusiveList(const IntrusiveList &);
+  IntrusiveList & operator= (const IntrusiveList &);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// IntrusiveList implementation
+
+template <typename T, typename Disposer>
+IntrusiveList<T, Disposer>::IntrusiveList(Disposer dispose_in)
+  : dispose(dispose_in) {
+  sentinel.prev = sentinel.next = &sentinel;
+}
+
+template <typename T, typename Disposer>
+IntrusiveList<T, Disposer>::IntrusiveList(IntrusiveList &&other)
+  : dispose(other.dispose) {
+  sentinel.prev = sentinel.next = &sentinel;
+  if (other.empty()) return;
+  // the end elements point at other's sentinel, so repoint them at ours
+  sentinel.next = other.sentinel.next;
+  sentinel.prev = other.sentinel.prev;
+  sentinel.next->prev = &sentinel;
+  sentinel.prev->next = &sentinel;
+  other.sentinel.prev = other.sentinel.next = &other.sentinel;
+}
+
+template <typename T, typename Disposer>
+IntrusiveList<T, Disposer>::~IntrusiveList() {
+  clear();
+}
+
+template <typename T, typename Disposer>
+T & IntrusiveList<T, Disposer>::front() const {
+  assert(!empty());
+  return *static_cast<T *>(sentinel.next);
+}
+
+template <typename T, typename Disposer>
+T & IntrusiveList<T, Disposer>::back() const {
+  assert(!empty());
+  return *static_cast<T *>(sentinel.prev);
+}
+
+template <typename T, typename Disposer>
+void IntrusiveList<T, Disposer>::link_before(ListHook *next, T &obj) {
+  ListHook *hook = &obj;
+  assert(!hook->is_linked());
+  hook->prev = next->prev;
+  hook->next = next;
+  next->prev->next = hook;
+  next->prev = hook;
+}
+
+template <typename T, typename Disposer>
+ListHook * IntrusiveList<T, Disposer>::remove(ListHook *p) {
+  assert(p != &sentinel);
+  ListHook *next = p->next;
+  p->unlink();
+  dispose(static_cast<T *>(p));
+  return next;
+}
+
+template <typename T, typename Disposer>
+void IntrusiveList<T, Disposer>::push_front(T &obj) {
+  link_before(sentinel.next, obj);
+  trace_op(TRACE_PUSH_FRONT, this);
+}
+
+template <typename T, typename Disposer>
+void IntrusiveList<T, Disposer>::push_back(T &obj) {
+  link_before(&sentinel, obj);
+  trace_op(TRACE_PUSH_BACK, this);
+}
+
+template <typename T, typename Disposer>
+void IntrusiveList<T, Disposer>::pop_front() {
+  assert(!empty());
+  remove(sentinel.next);
+  trace_op(TRACE_POP_FRONT, this);
+}
+
+template <typename T, typename Disposer>
+void IntrusiveList<T, Disposer>::pop_back() {
+  assert(!empty());
+  remove(sentinel.prev);
+  trace_op(TRACE_POP_BACK, this);
+}
+
+template <typename T, typename Disposer>
+typename IntrusiveList<T, Disposer>::Iterator
+IntrusiveList<T, Disposer>::insert(Iterator pos, T &obj) {
+  assert(pos.hook_ptr);
+  link_before(pos.hook_ptr, obj);
+  trace_op(TRACE_INSERT, this);
+  return Iterator(&obj);
+}
+
+template <typename T, typename Disposer>
+typename IntrusiveList<T, Disposer>::Iterator
+IntrusiveList<T, Disposer>::erase(Iterator pos) {
+  assert(pos.hook_ptr);
+  ListHook *next = remove(pos.hook_ptr);
+  trace_op(TRACE_ERASE, this);
+  return Iterator(next);
+}
+
+template <typename T, typename Disposer>
+void IntrusiveList<T, Disposer>::clear() {
+  while (!empty()) {
+    remove(sentinel.next);
+  }
+}
+
+#endif
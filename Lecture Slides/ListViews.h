@@ -0,0 +1,400 @@
+#ifndef LISTVIEWS_H
+#define LISTVIEWS_H
+/* ListViews.h
+ *
+ * Lazy views of a List<T>, or of any container with begin() and end().  A
+ * view doesn't copy or allocate anything: it remembers the container and
+ * what to do with its elements, and does it while it is being iterated.
+ *
+ *   List<int> l;
+ *   ...
+ *   // the squares of the first 10 elements greater than 6, where Square
+ *   // is a functor that returns x*x
+ *   long sum = 0;
+ *   for (int x : take(transform(filter(l, GreaterN(6)), Square()), 10)) {
+ *     sum += x;
+ *   }
+ *
+ * Views can be wrapped in other views, as above.  Each element goes
+ * through the whole pipeline before the next one is looked at, so the
+ * list is walked once, and stops early when take() has enough.  The
+ * functors are members of the views, so the compiler can inline them.
+ *
+ * A view holds a pointer to its container, not a copy, so the container
+ * must outlive it, and the view must outlive its Iterators.  Views
+ * themselves are small, and a view wraps a copy of the views inside it.
+ * Like the functors in 21_Functors.cpp, a functor may keep state, which
+ * lasts as long as its view.
+ */
+
+#include <cstddef>     //size_t, ptrdiff_t
+#include <iterator>    //forward_iterator_tag, input_iterator_tag
+#include <type_traits> //conditional, decay, is_base_of, is_reference
+#include <utility>     //declval, pair
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Ranges
+
+// base class of every view, so views can tell other views from containers
+struct ListView {};
+
+template <typename Container>
+class ContainerRef : public ListView {
+  //OVERVIEW: view of all the elements of a container, which it doesn't own
+ public:
+  typedef decltype(std::declval<const Container &>().begin()) Iterator;
+  typedef Iterator ConstIterator;
+
+  explicit ContainerRef(const Container &container_in)
+    : container(&container_in) {}
+
+  Iterator begin() const { return container->begin(); }
+  Iterator end() const { return container->end(); }
+
+ private:
+  const Container *container;
+};
+
+// ViewOf<Range>::type is what a view stores to get at Range: a copy of
+// Range if it is a view, or a ContainerRef if it is a container
+template <typename Range>
+struct ViewOf {
+  typedef typename std::conditional<std::is_base_of<ListView, Range>::value,
+                                    Range, ContainerRef<Range> >::type type;
+};
+
+//EFFECTS: returns a view of range
+template <typename Range>
+typename ViewOf<Range>::type view_of(const Range &range) {
+  return typename ViewOf<Range>::type(range);
+}
+
+// The iterator traits of a view that passes on the elements of BaseIterator.
+// They are worked out from operator*, since not every container's Iterator
+// declares them.  Elements returned by value, e.g. by a TransformView, can
+// only be read once per visit, so the view is then an input iterator.
+template <typename BaseIterator>
+struct PassTraits {
+  typedef decltype(*std::declval<BaseIterator>()) reference;
+  typedef typename std::decay<reference>::type value_type;
+  typedef typename std::remove_reference<reference>::type *pointer;
+  typedef typename std::conditional<std::is_reference<reference>::value,
+                                    std::forward_iterator_tag,
+                                    std::input_iterator_tag>::type
+    iterator_category;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FilterView
+template <typename Base, typename Predicate>
+class FilterView : public ListView {
+  //OVERVIEW: view of the elements of Base for which Predicate is true
+ public:
+  typedef typename Base::Iterator BaseIterator;
+
+  class Iterator {
+   public:
+    typedef typename PassTraits<BaseIterator>::iterator_category
+      iterator_category;
+    typedef typename PassTraits<BaseIterator>::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename PassTraits<BaseIterator>::pointer pointer;
+    typedef typename PassTraits<BaseIterator>::reference reference;
+
+    Iterator() : view(0) {}
+
+    reference operator* () const { return *it; }
+    pointer operator-> () const { return &*it; }
+
+    Iterator& operator++ () {
+      ++it;
+      skip();
+      return *this;
+    }
+
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    bool operator!= (const Iterator &rhs) const { return it != rhs.it; }
+    bool operator== (const Iterator &rhs) const { return it == rhs.it; }
+
+   private:
+    BaseIterator it;
+    BaseIterator end;
+    const FilterView *view; //for its predicate
+    friend class FilterView;
+
+    Iterator(BaseIterator it_in, BaseIterator end_in, const FilterView *v)
+      : it(it_in), end(end_in), view(v) {
+      skip();
+    }
+
+    //EFFECTS: moves it to the first element from here on that passes
+    void skip() {
+      while (it != end && !view->pred(*it)) ++it;
+    }
+  };//FilterView::Iterator
+  typedef Iterator ConstIterator;
+
+  FilterView(const Base &base_in, Predicate pred_in)
+    : base(base_in), pred(pred_in) {}
+
+  Iterator begin() const { return Iterator(base.begin(), base.end(), this); }
+  Iterator end() const { return Iterator(base.end(), base.end(), this); }
+
+ private:
+  Base base;
+  // mutable, since the functors in 21_Functors.cpp have non-const
+  // operator() and may keep state
+  mutable Predicate pred;
+};
+
+//EFFECTS: returns a view of the elements of range for which pred is true
+template <typename Range, typename Predicate>
+FilterView<typename ViewOf<Range>::type, Predicate>
+filter(const Range &range, Predicate pred) {
+  return FilterView<typename ViewOf<Range>::type, Predicate>(
+    view_of(range), pred);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// TransformView
+template <typename Base, typename Function>
+class TransformView : public ListView {
+  //OVERVIEW: view of f(x) for each element x of Base
+ public:
+  typedef typename Base::Iterator BaseIterator;
+  typedef typename std::decay<
+    decltype(std::declval<Function &>()(*std::declval<BaseIterator>()))
+  >::type Result;
+
+  class Iterator {
+   public:
+    // f(x) is computed on each access and returned by value, so this is
+    // an input iterator
+    typedef std::input_iterator_tag iterator_category;
+    typedef Result value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Result* pointer;
+    typedef Result reference;
+
+    Iterator() : view(0) {}
+
+    Result operator* () const { return view->f(*it); }
+
+    Iterator& operator++ () {
+      ++it;
+      return *this;
+    }
+
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++it;
+      return tmp;
+    }
+
+    bool operator!= (const Iterator &rhs) const { return it != rhs.it; }
+    bool operator== (const Iterator &rhs) const { return it == rhs.it; }
+
+   private:
+    BaseIterator it;
+    const TransformView *view; //for its function
+    friend class TransformView;
+
+    Iterator(BaseIterator it_in, const TransformView *v)
+      : it(it_in), view(v) {}
+  };//TransformView::Iterator
+  typedef Iterator ConstIterator;
+
+  TransformView(const Base &base_in, Function f_in)
+    : base(base_in), f(f_in) {}
+
+  Iterator begin() const { return Iterator(base.begin(), this); }
+  Iterator end() const { return Iterator(base.end(), this); }
+
+ private:
+  Base base;
+  mutable Function f;
+};
+
+//EFFECTS: returns a view of f(x) for each element x of range
+template <typename Range, typename Function>
+TransformView<typename ViewOf<Range>::type, Function>
+transform(const Range &range, Function f) {
+  return TransformView<typename ViewOf<Range>::type, Function>(
+    view_of(range), f);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// TakeView
+template <typename Base>
+class TakeView : public ListView {
+  //OVERVIEW: view of the first n elements of Base, or all of them if Base
+  //          has fewer
+ public:
+  typedef typename Base::Iterator BaseIterator;
+
+  class Iterator {
+   public:
+    typedef typename PassTraits<BaseIterator>::iterator_category
+      iterator_category;
+    typedef typename PassTraits<BaseIterator>::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename PassTraits<BaseIterator>::pointer pointer;
+    typedef typename PassTraits<BaseIterator>::reference reference;
+
+    Iterator() : left(0) {}
+
+    reference operator* () const { return *it; }
+    pointer operator-> () const { return &*it; }
+
+    // The base only moves on if there are elements still to take, so that
+    // taking the last one doesn't make a FilterView look for another.
+    Iterator& operator++ () {
+      --left;
+      if (left > 0) ++it;
+      return *this;
+    }
+
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    // All finished Iterators are equal, whether they ran out of elements
+    // or reached n.  This way end() doesn't have to find the nth element.
+    bool operator== (const Iterator &rhs) const {
+      bool done = finished(), rhs_done = rhs.finished();
+      return done || rhs_done ? done == rhs_done : it == rhs.it;
+    }
+
+    bool operator!= (const Iterator &rhs) const { return !(*this == rhs); }
+
+   private:
+    BaseIterator it;
+    BaseIterator end;
+    std::size_t left; //elements still to take
+    friend class TakeView;
+
+    Iterator(BaseIterator it_in, BaseIterator end_in, std::size_t left_in)
+      : it(it_in), end(end_in), left(left_in) {}
+
+    bool finished() const { return left == 0 || it == end; }
+  };//TakeView::Iterator
+  typedef Iterator ConstIterator;
+
+  TakeView(const Base &base_in, std::size_t n_in)
+    : base(base_in), n(n_in) {}
+
+  Iterator begin() const { return Iterator(base.begin(), base.end(), n); }
+  Iterator end() const { return Iterator(base.end(), base.end(), 0); }
+
+ private:
+  Base base;
+  std::size_t n;
+};
+
+//EFFECTS: returns a view of the first n elements of range
+template <typename Range>
+TakeView<typename ViewOf<Range>::type>
+take(const Range &range, std::size_t n) {
+  return TakeView<typename ViewOf<Range>::type>(view_of(range), n);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ZipView
+template <typename Base1, typename Base2>
+class ZipView : public ListView {
+  //OVERVIEW: view of pairs of elements at the same position in Base1 and
+  //          Base2, as long as the shorter of them
+ public:
+  typedef typename Base1::Iterator BaseIterator1;
+  typedef typename Base2::Iterator BaseIterator2;
+  typedef std::pair<
+    typename std::decay<decltype(*std::declval<BaseIterator1>())>::type,
+    typename std::decay<decltype(*std::declval<BaseIterator2>())>::type>
+  Pair;
+
+  class Iterator {
+   public:
+    // pairs are made on each access and returned by value
+    typedef std::input_iterator_tag iterator_category;
+    typedef Pair value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Pair* pointer;
+    typedef Pair reference;
+
+    Iterator() {}
+
+    Pair operator* () const { return Pair(*it1, *it2); }
+
+    Iterator& operator++ () {
+      ++it1;
+      ++it2;
+      return *this;
+    }
+
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    // like TakeView, all finished Iterators are equal
+    bool operator== (const Iterator &rhs) const {
+      bool done = finished(), rhs_done = rhs.finished();
+      return done || rhs_done ? done == rhs_done : it1 == rhs.it1;
+    }
+
+    bool operator!= (const Iterator &rhs) const { return !(*this == rhs); }
+
+   private:
+    BaseIterator1 it1, end1;
+    BaseIterator2 it2, end2;
+    friend class ZipView;
+
+    Iterator(BaseIterator1 it1_in, BaseIterator1 end1_in,
+             BaseIterator2 it2_in, BaseIterator2 end2_in)
+      : it1(it1_in), end1(end1_in), it2(it2_in), end2(end2_in) {}
+
+    bool finished() const { return it1 == end1 || it2 == end2; }
+  };//ZipView::Iterator
+  typedef Iterator ConstIterator;
+
+  ZipView(const Base1 &base1_in, const Base2 &base2_in)
+    : base1(base1_in), base2(base2_in) {}
+
+  Iterator begin() const {
+    return Iterator(base1.begin(), base1.end(), base2.begin(), base2.end());
+  }
+
+  Iterator end() const {
+    return Iterator(base1.end(), base1.end(), base2.end(), base2.end());
+  }
+
+ private:
+  Base1 base1;
+  Base2 base2;
+};
+
+//EFFECTS: returns a view of pairs of elements of range1 and range2
+template <typename Range1, typename Range2>
+ZipView<typename ViewOf<Range1>::type, typename ViewOf<Range2>::type>
+zip(const Range1 &range1, const Range2 &range2) {
+  return ZipView<typename ViewOf<Range1>::type,
+                 typename ViewOf<Range2>::type>(view_of(range1),
+                                                view_of(range2));
+}
+
+#endif
@@ -0,0 +1,1703 @@
+/* List_Benchmark.cpp
+ *
+ * Benchmarks for List<T>.  Prints one JSON result per line.
+ *
+ * $ g++ -std=c++11 -O2 -DNDEBUG -pthread List_Benchmark.cpp
+ * $ ./a.out         # run every group
+ * $ ./a.out GROUP   # run one group: pool, unrolled, move, splice,
+ *                   # concurrent, lru, sort, duplicates, intrusive,
+ *                   # immutable, compact, parallel, views,
+ *                   # predicates, batch, classify
+ */
+
+#include "20_List_with_Iterator.h"
+#include "NodePool.h"
+#include "UnrolledList.h"
+#include "ConcurrentList.h"
+#include "DoublyLinkedList.h"
+#include "Duplicates.h"
+#include "IntrusiveList.h"
+#include "ImmutableList.h"
+#include "MemoryStats.h"
+#include "ParallelList.h"
+#include "ListViews.h"
+#include "Predicates.h"
+#include "BatchPredicates.h"
+#include "RangeClassifier.h"
+#include "Benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// pool: push/pop churn with and without a NodePool
+
+//REQUIRES: l is empty
+//MODIFIES: l
+//EFFECTS: keeps l at size elements with push_back/pop_front pairs, as a
+//         work queue would, and prints the cost of each pair
+template <typename ListType>
+void bench_queue_churn(const string &impl, ListType &l, int size, int ops) {
+  for (int i = 0; i < size; ++i) l.push_back(i);
+
+  long long allocs_before = g_alloc_stats.allocs.load();
+  long long start = now_ns();
+  long long sum = 0;
+  for (int i = 0; i < ops; ++i) {
+    l.push_back(i);
+    sum += l.front();
+    l.pop_front();
+  }
+  long long elapsed = now_ns() - start;
+  long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+  while (!l.empty()) l.pop_front();
+
+  BenchmarkRow().add("group", "pool")
+                .add("impl", impl)
+                .add("workload", "queue_churn")
+                .add("size", size)
+                .add("ops", ops)
+                .add("ns_per_op", double(elapsed) / ops)
+                .add("allocs", allocs)
+                .add("checksum", sum)
+                .print(cout);
+}
+
+//REQUIRES: l is empty
+//MODIFIES: l
+//EFFECTS: repeatedly fills l with size elements and drains it again, and
+//         prints the cost of each push/pop pair
+template <typename ListType>
+void bench_fill_drain(const string &impl, ListType &l, int size, int rounds) {
+  long long allocs_before = g_alloc_stats.allocs.load();
+  long long start = now_ns();
+  long long sum = 0;
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < size; ++i) l.push_front(i);
+    while (!l.empty()) {
+      sum += l.front();
+      l.pop_front();
+    }
+  }
+  long long elapsed = now_ns() - start;
+  long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+  long long ops = static_cast<long long>(size) * rounds;
+
+  BenchmarkRow().add("group", "pool")
+                .add("impl", impl)
+                .add("workload", "fill_drain")
+                .add("size", size)
+                .add("ops", ops)
+                .add("ns_per_op", double(elapsed) / ops)
+                .add("allocs", allocs)
+                .add("checksum", sum)
+                .print(cout);
+}
+
+// One PoolAllocator used for objects of two sizes: a vector's strings and
+// a List's nodes.  Checks that blocks of either size are usable, and that
+// the pools get them all back.
+void check_pool_mixed_sizes() {
+  const int SIZE = 1000;
+  {
+    PoolAllocator<string> alloc;
+    vector<string, PoolAllocator<string> > v(alloc);
+    List<string, PoolAllocator<string> > l(alloc);
+    for (int i = 0; i < SIZE; ++i) {
+      l.push_back(string(40, 'a' + i % 26));
+      v.push_back(l.back());
+      // a single string, from the pool for sizeof(string)
+      vector<string, PoolAllocator<string> > one(1, l.back(), alloc);
+      bench_check(one[0] == v.back(), "pool: shared pool string");
+    }
+    bench_check(v.size() == static_cast<size_t>(SIZE) &&
+                v[7] == string(40, 'h') && v.back() == l.back(),
+                "pool: shared pool contents");
+  }
+  {
+    NodePool pool;
+    PoolAllocator<string> alloc(pool);
+    vector<string, PoolAllocator<string> > one(1, string("x"), alloc);
+    List<string, PoolAllocator<string> > l(alloc);
+    for (int i = 0; i < SIZE; ++i) l.push_front(string(40, 'b'));
+    bench_check(one[0] == "x" && l.front() == string(40, 'b'),
+                "pool: explicit pool contents");
+    // the string came first and set the block size, so the nodes, which
+    // are bigger, came from operator new
+    bench_check(pool.live_blocks() == 1, "pool: explicit pool live blocks");
+    while (!l.empty()) l.pop_front();
+  }
+  {
+    // types of the same size share a thread's pool
+    static_assert(sizeof(int) == sizeof(float), "int and float sizes");
+    NodePool &shared = shared_size_pool<sizeof(int)>();
+    size_t live = shared.live_blocks();
+    PoolAllocator<int> ints;
+    PoolAllocator<float> floats;
+    int *i = ints.allocate(1);
+    float *f = floats.allocate(1);
+    bench_check(shared.live_blocks() == live + 2, "pool: shared by size");
+    floats.deallocate(f, 1);
+    ints.deallocate(i, 1);
+    bench_check(shared.live_blocks() == live, "pool: shared pool released");
+  }
+}
+
+void bench_pool() {
+  check_pool_mixed_sizes();
+  const int OPS = 2000000;
+  const int sizes[] = {16, 1024, 65536};
+  for (int s = 0; s < 3; ++s) {
+    int size = sizes[s];
+    int rounds = OPS / size;
+    {
+      List<int> l;
+      bench_queue_churn("List<int>", l, size, OPS);
+      bench_fill_drain("List<int>", l, size, rounds);
+    }
+    {
+      List<int, PoolAllocator<int> > l;
+      bench_queue_churn("List<int, PoolAllocator> shared", l, size, OPS);
+      bench_fill_drain("List<int, PoolAllocator> shared", l, size, rounds);
+    }
+    {
+      NodePool pool;
+      List<int, PoolAllocator<int> > l((PoolAllocator<int>(pool)));
+      bench_queue_churn("List<int, PoolAllocator> per-list", l, size, OPS);
+      bench_fill_drain("List<int, PoolAllocator> per-list", l, size, rounds);
+    }
+    {
+      // the cost of accounting: same as List<int>, plus counters
+      MemoryStats stats("List<int, CountingAllocator>");
+      List<int, CountingAllocator<int> > l((CountingAllocator<int>(stats)));
+      bench_queue_churn("List<int, CountingAllocator>", l, size, OPS);
+      bench_fill_drain("List<int, CountingAllocator>", l, size, rounds);
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// unrolled: traversal of List<int> against UnrolledList<int>
+
+//EFFECTS: returns the sum of the elements of l
+template <typename Container>
+long long sum_all(const Container &l) {
+  long long sum = 0;
+  for (typename Container::ConstIterator i = l.begin(); i != l.end(); ++i) {
+    sum += *i;
+  }
+  return sum;
+}
+
+//EFFECTS: returns true if no element of l appears twice, comparing every
+//         pair like no_duplicates() in 20_Iterators.cpp
+template <typename Container>
+bool no_duplicates(const Container &l) {
+  for (typename Container::ConstIterator i = l.begin(); i != l.end(); ++i) {
+    typename Container::ConstIterator j = i; ++j;
+    for (; j != l.end(); ++j) {
+      if (*i == *j) return false;
+    }
+  }
+  return true;
+}
+
+//EFFECTS: prints the cost of building, traversing and scanning a
+//         Container of size ints
+template <typename Container>
+void bench_traversal(const string &impl, int size) {
+  long long live_before = live_bytes();
+  long long allocs_before = g_alloc_stats.allocs.load();
+  Container l;
+  long long start = now_ns();
+  for (int i = 0; i < size; ++i) l.push_back(i);
+  long long build = now_ns() - start;
+  long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+  long long bytes = live_bytes() - live_before;
+
+  const int ROUNDS = 20;
+  long long sum = 0;
+  start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) sum += sum_all(l);
+  long long traverse = now_ns() - start;
+
+  BenchmarkRow().add("group", "unrolled")
+                .add("impl", impl)
+                .add("workload", "traverse")
+                .add("size", size)
+                .add("build_ns_per_elt", double(build) / size)
+                .add("ns_per_elt", double(traverse) / ROUNDS / size)
+                .add("allocs", allocs)
+                .add("heap_bytes_per_elt", double(bytes) / size)
+                .add("checksum", sum)
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of the O(n^2) no_duplicates() scan over a
+//         Container of size distinct ints
+template <typename Container>
+void bench_no_duplicates(const string &impl, int size) {
+  Container l;
+  for (int i = 0; i < size; ++i) l.push_back(i);
+  long long start = now_ns();
+  bool unique = no_duplicates(l);
+  long long elapsed = now_ns() - start;
+  double pairs = double(size) * (size - 1) / 2;
+
+  BenchmarkRow().add("group", "unrolled")
+                .add("impl", impl)
+                .add("workload", "no_duplicates")
+                .add("size", size)
+                .add("ns_per_pair", elapsed / pairs)
+                .add("checksum", static_cast<int>(unique))
+                .print(cout);
+}
+
+void bench_unrolled() {
+  const int sizes[] = {1024, 1 << 20};
+  for (int s = 0; s < 2; ++s) {
+    bench_traversal<List<int> >("List<int>", sizes[s]);
+    bench_traversal<UnrolledList<int> >("UnrolledList<int>", sizes[s]);
+  }
+  bench_no_duplicates<List<int> >("List<int>", 4000);
+  bench_no_duplicates<UnrolledList<int> >("UnrolledList<int>", 4000);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// move: copying, moving and emplacing string-heavy elements
+
+// Like Gorilla in 19_zoo.cpp, but counts its copies instead of printing them
+class Gorilla {
+  std::string name;
+public:
+  static long long copies;
+  static long long moves;
+
+  Gorilla() : name("noname") {}
+  Gorilla(const std::string &name_in) : name(name_in) {}
+  Gorilla(const Gorilla &other) : name(other.name) { ++copies; }
+  Gorilla(Gorilla &&other) : name(std::move(other.name)) { ++moves; }
+
+  Gorilla & operator=(const Gorilla &rhs) {
+    name = rhs.name;
+    ++copies;
+    return *this;
+  }
+
+  std::size_t name_length() const { return name.size(); }
+};
+
+long long Gorilla::copies = 0;
+long long Gorilla::moves = 0;
+
+enum InsertMethod { PUSH_COPY, PUSH_MOVE, EMPLACE };
+
+//EFFECTS: prints the cost of inserting size Gorillas with the given method
+void bench_insert(const string &workload, InsertMethod method, int size) {
+  // long enough to defeat the small string optimization
+  const string name = "Gorilla gorilla gorilla, western lowland";
+  Gorilla::copies = Gorilla::moves = 0;
+  long long allocs_before = g_alloc_stats.allocs.load();
+  long long start = now_ns();
+  List<Gorilla> zoo;
+  for (int i = 0; i < size; ++i) {
+    if (method == PUSH_COPY) {
+      Gorilla g(name);
+      zoo.push_back(g);
+    } else if (method == PUSH_MOVE) {
+      Gorilla g(name);
+      zoo.push_back(std::move(g));
+    } else {
+      zoo.emplace_back(name);
+    }
+  }
+  long long elapsed = now_ns() - start;
+  long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+  long long checksum = 0;
+  for (List<Gorilla>::Iterator i = zoo.begin(); i != zoo.end(); ++i) {
+    checksum += i->name_length();
+  }
+
+  BenchmarkRow().add("group", "move")
+                .add("impl", "List<Gorilla>")
+                .add("workload", workload)
+                .add("size", size)
+                .add("ns_per_op", double(elapsed) / size)
+                .add("copies", Gorilla::copies)
+                .add("moves", Gorilla::moves)
+                .add("allocs_per_op", double(allocs) / size)
+                .add("checksum", checksum)
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of handing a List of size Gorillas to another
+//         List by copy and by move
+void bench_transfer(int size) {
+  List<Gorilla> zoo;
+  for (int i = 0; i < size; ++i) zoo.emplace_back("Colo");
+
+  Gorilla::copies = 0;
+  long long start = now_ns();
+  List<Gorilla> copy(zoo);
+  long long copy_ns = now_ns() - start;
+  long long copies = Gorilla::copies;
+
+  start = now_ns();
+  List<Gorilla> moved(std::move(zoo));
+  long long move_ns = now_ns() - start;
+
+  BenchmarkRow().add("group", "move")
+                .add("impl", "List<Gorilla>")
+                .add("workload", "transfer")
+                .add("size", size)
+                .add("copy_ns", copy_ns)
+                .add("copy_copies", copies)
+                .add("move_ns", move_ns)
+                .add("move_copies", Gorilla::copies - copies)
+                .print(cout);
+}
+
+void bench_move() {
+  const int SIZE = 200000;
+  bench_insert("push_back(const T&)", PUSH_COPY, SIZE);
+  bench_insert("push_back(T&&)", PUSH_MOVE, SIZE);
+  bench_insert("emplace_back", EMPLACE, SIZE);
+  bench_transfer(SIZE);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// splice: copying, merging and splitting job queues
+
+//EFFECTS: prints the cost of copying a List<int> of size elements with the
+//         copy constructor, against rebuilding it one push_back at a time
+void bench_copy(int size) {
+  List<int> jobs;
+  for (int i = 0; i < size; ++i) jobs.push_back(i);
+
+  long long allocs_before = g_alloc_stats.allocs.load();
+  long long start = now_ns();
+  List<int> rebuilt;
+  for (List<int>::Iterator i = jobs.begin(); i != jobs.end(); ++i) {
+    rebuilt.push_back(*i);
+  }
+  long long rebuild_ns = now_ns() - start;
+  long long rebuild_allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+  allocs_before = g_alloc_stats.allocs.load();
+  start = now_ns();
+  List<int> copy(jobs);
+  long long copy_ns = now_ns() - start;
+  long long copy_allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+  BenchmarkRow().add("group", "splice")
+                .add("impl", "List<int>")
+                .add("workload", "copy")
+                .add("size", size)
+                .add("push_back_ns_per_elt", double(rebuild_ns) / size)
+                .add("push_back_allocs", rebuild_allocs)
+                .add("copy_ns_per_elt", double(copy_ns) / size)
+                .add("copy_allocs", copy_allocs)
+                .add("checksum", sum_all(copy) - sum_all(rebuilt))
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of moving a queue of size jobs onto the back of
+//         another queue, element by element and with append()
+void bench_merge(int size, int rounds) {
+  List<int> a, b;
+  for (int i = 0; i < size; ++i) b.push_back(i);
+
+  // element by element: the queues trade jobs back and forth
+  long long start = now_ns();
+  for (int r = 0; r < rounds; ++r) {
+    List<int> &from = (r % 2 == 0) ? b : a;
+    List<int> &to = (r % 2 == 0) ? a : b;
+    while (!from.empty()) {
+      to.push_back(from.front());
+      from.pop_front();
+    }
+  }
+  long long copy_ns = now_ns() - start;
+
+  start = now_ns();
+  for (int r = 0; r < rounds; ++r) {
+    List<int> &from = (r % 2 == 0) ? b : a;
+    List<int> &to = (r % 2 == 0) ? a : b;
+    to.append(std::move(from));
+  }
+  long long append_ns = now_ns() - start;
+
+  BenchmarkRow().add("group", "splice")
+                .add("impl", "List<int>")
+                .add("workload", "merge")
+                .add("size", size)
+                .add("push_pop_ns_per_merge", double(copy_ns) / rounds)
+                .add("append_ns_per_merge", double(append_ns) / rounds)
+                .add("checksum", sum_all(a) + sum_all(b))
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of splitting a queue of size jobs after its
+//         first element and splicing the rest back in
+void bench_split(int size, int rounds) {
+  List<int> jobs;
+  for (int i = 0; i < size; ++i) jobs.push_back(i);
+
+  long long start = now_ns();
+  for (int r = 0; r < rounds; ++r) {
+    List<int> rest = jobs.split_after(jobs.begin());
+    jobs.splice_after(jobs.begin(), rest);
+  }
+  long long elapsed = now_ns() - start;
+
+  BenchmarkRow().add("group", "splice")
+                .add("impl", "List<int>")
+                .add("workload", "split_splice")
+                .add("size", size)
+                .add("ns_per_op", double(elapsed) / rounds)
+                .add("checksum", sum_all(jobs))
+                .print(cout);
+}
+
+void bench_splice() {
+  const int sizes[] = {1024, 1 << 20};
+  for (int s = 0; s < 2; ++s) {
+    bench_copy(sizes[s]);
+    bench_merge(sizes[s], 8);
+    bench_split(sizes[s], 100000);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// concurrent: work queue throughput with many producers and one consumer
+
+// The way List is shared between threads without ConcurrentList.h
+template <typename T>
+class LockedList {
+ public:
+  void push_back(const T &datum) {
+    std::lock_guard<std::mutex> lock(mutex);
+    list.push_back(datum);
+  }
+
+  bool try_pop_front(T &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (list.empty()) return false;
+    out = list.front();
+    list.pop_front();
+    return true;
+  }
+
+ private:
+  std::mutex mutex;
+  List<T> list;
+};
+
+//EFFECTS: pushes datum onto q, waiting while q is full
+template <typename Queue>
+void push_job(Queue &q, int datum) {
+  q.push_back(datum);
+}
+
+void push_job(SpscRing<int> &q, int datum) {
+  while (!q.try_push_back(datum)) this_thread::yield();
+}
+
+// An item for MpscQueue, which links the caller's objects
+struct Job : MpscHook {
+  int datum;
+};
+
+//EFFECTS: runs producers threads that push ops jobs in total onto q while
+//         this thread pops them, and prints the throughput
+template <typename Queue>
+void bench_producers(const string &impl, Queue &q, int producers, int ops) {
+  int per_producer = ops / producers;
+  ops = per_producer * producers;
+  atomic<bool> go(false);
+  vector<thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.push_back(thread([&q, &go, per_producer]() {
+      while (!go.load()) this_thread::yield();
+      for (int i = 0; i < per_producer; ++i) push_job(q, i);
+    }));
+  }
+
+  long long start = now_ns();
+  go.store(true);
+  long long sum = 0;
+  int datum = 0;
+  for (int popped = 0; popped < ops; ) {
+    if (q.try_pop_front(datum)) {
+      sum += datum;
+      ++popped;
+    } else {
+      this_thread::yield();
+    }
+  }
+  long long elapsed = now_ns() - start;
+  for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+
+  BenchmarkRow().add("group", "concurrent")
+                .add("impl", impl)
+                .add("producers", producers)
+                .add("cpus", static_cast<int>(thread::hardware_concurrency()))
+                .add("ops", ops)
+                .add("ns_per_op", double(elapsed) / ops)
+                .add("mops_per_s", ops * 1e3 / elapsed)
+                .add("checksum", sum)
+                .print(cout);
+}
+
+//EFFECTS: like bench_producers(), for the intrusive MpscQueue
+void bench_mpsc_producers(int producers, int ops) {
+  int per_producer = ops / producers;
+  ops = per_producer * producers;
+  vector<Job> jobs(ops);
+  MpscQueue<Job> q;
+  atomic<bool> go(false);
+  vector<thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    Job *mine = &jobs[0] + p * per_producer;
+    threads.push_back(thread([&q, &go, mine, per_producer]() {
+      while (!go.load()) this_thread::yield();
+      for (int i = 0; i < per_producer; ++i) {
+        mine[i].datum = i;
+        q.push_back(mine + i);
+      }
+    }));
+  }
+
+  long long start = now_ns();
+  go.store(true);
+  long long sum = 0;
+  for (int popped = 0; popped < ops; ) {
+    Job *job = q.try_pop_front();
+    if (job) {
+      sum += job->datum;
+      ++popped;
+    } else {
+      this_thread::yield();
+    }
+  }
+  long long elapsed = now_ns() - start;
+  for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+
+  BenchmarkRow().add("group", "concurrent")
+                .add("impl", "MpscQueue<Job>")
+                .add("producers", producers)
+                .add("cpus", static_cast<int>(thread::hardware_concurrency()))
+                .add("ops", ops)
+                .add("ns_per_op", double(elapsed) / ops)
+                .add("mops_per_s", ops * 1e3 / elapsed)
+                .add("checksum", sum)
+                .print(cout);
+}
+
+// One thread more than HazardPointers has records for.  Each thread uses
+// an MpmcQueue and holds on to its record until all have tried, so exactly
+// one of them must get a runtime_error instead of a crash.
+void check_mpmc_thread_limit() {
+  HazardPointers::claim(); //this thread's record, taken up front
+  MpmcQueue<int> q;
+  const int THREADS = HazardPointers::MAX_THREADS;
+  atomic<int> tried(0), refused(0), popped(0);
+  vector<thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.push_back(thread([&q, &tried, &refused, &popped, t]() {
+      try {
+        q.push_back(t);
+        int out;
+        popped += q.try_pop_front(out);
+      } catch (const runtime_error &) {
+        ++refused;
+      }
+      ++tried;
+      while (tried.load() < THREADS) this_thread::yield();
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+  bench_check(refused.load() == 1 && popped.load() == THREADS - 1,
+              "concurrent: MpmcQueue past MAX_THREADS");
+  int out;
+  bench_check(!q.try_pop_front(out), "concurrent: MpmcQueue left empty");
+}
+
+void bench_concurrent() {
+  check_mpmc_thread_limit();
+  const int OPS = 1000000;
+  {
+    SpscRing<int> q(4096);
+    bench_producers("SpscRing<int>", q, 1, OPS);
+  }
+  for (int producers = 1; producers <= 32; producers *= 2) {
+    {
+      LockedList<int> q;
+      bench_producers("List<int> + mutex", q, producers, OPS);
+    }
+    {
+      MpmcQueue<int> q;
+      bench_producers("MpmcQueue<int>", q, producers, OPS);
+    }
+    bench_mpsc_producers(producers, OPS);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// lru: erasing from the middle of a doubly-linked list
+
+//EFFECTS: runs an LRU cache of capacity keys over ops random lookups, and
+//         prints the cost of each lookup.  A hit moves its key to the front
+//         with erase() and push_front(); a miss evicts with pop_back().
+template <typename ListType, typename Iterator>
+void bench_lru(const string &impl, int capacity, int ops) {
+  ListType recent;
+  unordered_map<int, Iterator> where;
+  where.reserve(capacity * 2);
+  mt19937 rng(280);
+  uniform_int_distribution<int> key_dist(0, capacity * 2 - 1);
+
+  long long hits = 0;
+  long long start = now_ns();
+  for (int i = 0; i < ops; ++i) {
+    int key = key_dist(rng);
+    typename unordered_map<int, Iterator>::iterator found = where.find(key);
+    if (found != where.end()) {
+      ++hits;
+      recent.erase(found->second);
+      recent.push_front(key);
+      found->second = recent.begin();
+      continue;
+    }
+    if (static_cast<int>(where.size()) == capacity) {
+      where.erase(recent.back());
+      recent.pop_back();
+    }
+    recent.push_front(key);
+    where[key] = recent.begin();
+  }
+  long long elapsed = now_ns() - start;
+
+  BenchmarkRow().add("group", "lru")
+                .add("impl", impl)
+                .add("capacity", capacity)
+                .add("ops", ops)
+                .add("ns_per_op", double(elapsed) / ops)
+                .add("checksum", hits)
+                .print(cout);
+}
+
+void bench_lru_group() {
+  const int OPS = 2000000;
+  const int capacities[] = {1024, 1 << 18};
+  for (int c = 0; c < 2; ++c) {
+    bench_lru<DoublyLinkedList<int>, DoublyLinkedList<int>::Iterator>(
+      "DoublyLinkedList<int>", capacities[c], OPS);
+    bench_lru<std::list<int>, std::list<int>::iterator>(
+      "std::list<int>", capacities[c], OPS);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// sort: sorting, merging and deduplicating a List in place
+
+//EFFECTS: returns a list of size random ints from seed
+List<int> random_list(int size, unsigned seed) {
+  mt19937 rng(seed);
+  List<int> l;
+  for (int i = 0; i < size; ++i) l.push_back(static_cast<int>(rng() >> 1));
+  return l;
+}
+
+//EFFECTS: prints the cost of sorting size random ints with List::sort(),
+//         with a copy through a vector and back, and with std::list::sort()
+void bench_sort(int size) {
+  long long relink_ns, vector_ns, std_list_ns, allocs, vector_allocs;
+  long long checksum = 0;
+  {
+    List<int> l = random_list(size, 280);
+    long long allocs_before = g_alloc_stats.allocs.load();
+    long long start = now_ns();
+    l.sort();
+    relink_ns = now_ns() - start;
+    allocs = g_alloc_stats.allocs.load() - allocs_before;
+    checksum += l.front();
+  }
+  {
+    List<int> l = random_list(size, 280);
+    long long allocs_before = g_alloc_stats.allocs.load();
+    long long start = now_ns();
+    vector<int> v;
+    while (!l.empty()) {
+      v.push_back(l.front());
+      l.pop_front();
+    }
+    stable_sort(v.begin(), v.end());
+    for (size_t i = 0; i < v.size(); ++i) l.push_back(v[i]);
+    vector_ns = now_ns() - start;
+    vector_allocs = g_alloc_stats.allocs.load() - allocs_before;
+    checksum -= l.front();
+  }
+  {
+    mt19937 rng(280);
+    std::list<int> l;
+    for (int i = 0; i < size; ++i) l.push_back(static_cast<int>(rng() >> 1));
+    long long start = now_ns();
+    l.sort();
+    std_list_ns = now_ns() - start;
+    checksum += l.front();
+  }
+
+  BenchmarkRow().add("group", "sort")
+                .add("impl", "List<int>")
+                .add("workload", "sort")
+                .add("size", size)
+                .add("sort_ns_per_elt", double(relink_ns) / size)
+                .add("sort_allocs", allocs)
+                .add("via_vector_ns_per_elt", double(vector_ns) / size)
+                .add("via_vector_allocs", vector_allocs)
+                .add("std_list_ns_per_elt", double(std_list_ns) / size)
+                .add("checksum", checksum)
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of merging two sorted lists of size / 2 random
+//         ints, and of removing the duplicates from the result
+void bench_merge_unique(int size) {
+  List<int> a = random_list(size / 2, 1);
+  List<int> b = random_list(size / 2, 2);
+  // Make about half the elements duplicates.  size random draws from m
+  // values hit about m * (1 - e^(-size / m)) of them, which is size / 2
+  // when m is about 5/8 of size.
+  const int values = size / 8 * 5;
+  for (List<int>::Iterator i = a.begin(); i != a.end(); ++i) *i %= values;
+  for (List<int>::Iterator i = b.begin(); i != b.end(); ++i) *i %= values;
+  a.sort();
+  b.sort();
+
+  long long start = now_ns();
+  a.merge(std::move(b));
+  long long merge_ns = now_ns() - start;
+
+  start = now_ns();
+  a.unique();
+  long long unique_ns = now_ns() - start;
+
+  BenchmarkRow().add("group", "sort")
+                .add("impl", "List<int>")
+                .add("workload", "merge_unique")
+                .add("size", size)
+                .add("merge_ns_per_elt", double(merge_ns) / size)
+                .add("unique_ns_per_elt", double(unique_ns) / size)
+                .add("checksum", sum_all(a))
+                .print(cout);
+}
+
+void bench_sort_group() {
+  const int sizes[] = {100000, 10000000};
+  for (int s = 0; s < 2; ++s) {
+    bench_sort(sizes[s]);
+    bench_merge_unique(sizes[s]);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// duplicates: pairwise no_duplicates() against hash-based detection
+
+//EFFECTS: prints the cost of checking a List<int> of size distinct
+//         elements, the worst case since no search can stop early, and of
+//         listing the duplicates when one element in eight repeats
+void bench_duplicates(int size) {
+  List<int> distinct, repeats;
+  mt19937 rng(280);
+  for (int i = 0; i < size; ++i) {
+    distinct.push_back(static_cast<int>(rng() >> 1));
+    repeats.push_back(i % 8 == 7 ? i - 1 : i);
+  }
+
+  const int ROUNDS = size < 1000 ? 10000 : 1;
+  double pairwise_ns = -1; //not run for large sizes
+  long long checksum = 0;
+  if (size <= 4000) {
+    long long start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) checksum += no_duplicates(distinct);
+    pairwise_ns = double(now_ns() - start) / ROUNDS;
+  }
+
+  long long start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    checksum += first_duplicate(distinct.begin(), distinct.end()) ==
+                distinct.end();
+  }
+  double first_ns = double(now_ns() - start) / ROUNDS;
+
+  start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    checksum += all_duplicates(repeats.begin(), repeats.end()).size();
+  }
+  double all_ns = double(now_ns() - start) / ROUNDS;
+
+  BenchmarkRow().add("group", "duplicates")
+                .add("impl", "List<int>")
+                .add("size", size)
+                .add("no_duplicates_ns", pairwise_ns)
+                .add("first_duplicate_ns", first_ns)
+                .add("all_duplicates_ns", all_ns)
+                .add("checksum", checksum)
+                .print(cout);
+}
+
+void bench_duplicates_group() {
+  const int sizes[] = {16, 64, 1000, 4000, 1 << 20};
+  for (int s = 0; s < 5; ++s) bench_duplicates(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// intrusive: List<Item*> against IntrusiveList<Item> for objects on the heap
+
+struct Item : public ListHook {
+  int value;
+  explicit Item(int value_in) : value(value_in) {}
+};
+
+//EFFECTS: prints the cost of linking size existing Items into a
+//         container, summing them, and removing them in random order
+void bench_intrusive(int size) {
+  vector<Item *> items;
+  for (int i = 0; i < size; ++i) items.push_back(new Item(i));
+  vector<int> order(size);
+  for (int i = 0; i < size; ++i) order[i] = i;
+  shuffle(order.begin(), order.end(), mt19937(280));
+  const int ROUNDS = 20;
+
+  // List<Item*>: a Node per Item, and removing one means finding it first
+  {
+    long long allocs_before = g_alloc_stats.allocs.load();
+    List<Item *> l;
+    long long start = now_ns();
+    for (int i = 0; i < size; ++i) l.push_back(items[i]);
+    long long build = now_ns() - start;
+    long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+    long long sum = 0;
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      for (List<Item *>::Iterator i = l.begin(); i != l.end(); ++i) {
+        sum += (*i)->value;
+      }
+    }
+    long long traverse = now_ns() - start;
+
+    BenchmarkRow().add("group", "intrusive")
+                  .add("impl", "List<Item*>")
+                  .add("size", size)
+                  .add("build_ns_per_elt", double(build) / size)
+                  .add("traverse_ns_per_elt", double(traverse) / ROUNDS / size)
+                  .add("remove_ns_per_elt", -1) //O(n) search each
+                  .add("allocs", allocs)
+                  .add("checksum", sum)
+                  .print(cout);
+  }
+
+  {
+    long long allocs_before = g_alloc_stats.allocs.load();
+    IntrusiveList<Item> l;
+    long long start = now_ns();
+    for (int i = 0; i < size; ++i) l.push_back(*items[i]);
+    long long build = now_ns() - start;
+    long long allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+    long long sum = 0;
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      for (IntrusiveList<Item>::Iterator i = l.begin(); i != l.end(); ++i) {
+        sum += i->value;
+      }
+    }
+    long long traverse = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < size; ++i) items[order[i]]->unlink();
+    long long remove = now_ns() - start;
+    sum += l.empty();
+
+    BenchmarkRow().add("group", "intrusive")
+                  .add("impl", "IntrusiveList<Item>")
+                  .add("size", size)
+                  .add("build_ns_per_elt", double(build) / size)
+                  .add("traverse_ns_per_elt", double(traverse) / ROUNDS / size)
+                  .add("remove_ns_per_elt", double(remove) / size)
+                  .add("allocs", allocs)
+                  .add("checksum", sum)
+                  .print(cout);
+  }
+
+  for (int i = 0; i < size; ++i) delete items[i];
+}
+
+void bench_intrusive_group() {
+  const int sizes[] = {1000, 100000, 1000000};
+  for (int s = 0; s < 3; ++s) bench_intrusive(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// immutable: deep copies of List<int> against shared ImmutableList<int>
+
+//EFFECTS: prints the cost of taking a snapshot of a size element list and
+//         reading it, first by copying a List, then by sharing an
+//         ImmutableList.  Each of the reader threads takes its own snapshot.
+void bench_immutable(int size, int readers) {
+  List<int> list;
+  ImmutableList<int> shared;
+  for (int i = 0; i < size; ++i) {
+    list.push_front(i);
+    shared = shared.push_front(i);
+  }
+
+  const int ROUNDS = size < 100000 ? 100 : 3;
+  long long sums[2] = {0, 0};
+  long long elapsed[2];
+  for (int impl = 0; impl < 2; ++impl) {
+    vector<long long> partial(readers);
+    long long start = now_ns();
+    vector<thread> threads;
+    for (int t = 0; t < readers; ++t) {
+      threads.push_back(thread([&, impl, t]() {
+        for (int r = 0; r < ROUNDS; ++r) {
+          if (impl == 0) {
+            List<int> snapshot = list;
+            partial[t] += sum_all(snapshot);
+          } else {
+            ImmutableList<int> snapshot = shared;
+            partial[t] += sum_all(snapshot);
+          }
+        }
+      }));
+    }
+    for (int t = 0; t < readers; ++t) threads[t].join();
+    elapsed[impl] = now_ns() - start;
+    for (int t = 0; t < readers; ++t) sums[impl] += partial[t];
+  }
+
+  const char * const impls[2] = {"List<int> copy", "ImmutableList<int>"};
+  for (int impl = 0; impl < 2; ++impl) {
+    BenchmarkRow().add("group", "immutable")
+                  .add("impl", impls[impl])
+                  .add("workload", "snapshot_and_read")
+                  .add("size", size)
+                  .add("readers", readers)
+                  .add("ns_per_snapshot",
+                       double(elapsed[impl]) / ROUNDS / readers)
+                  .add("checksum", sums[impl])
+                  .print(cout);
+  }
+}
+
+void bench_immutable_group() {
+  const int sizes[] = {1000, 1000000};
+  for (int s = 0; s < 2; ++s) {
+    bench_immutable(sizes[s], 1);
+    bench_immutable(sizes[s], 4);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// compact: traversal of a scattered List<int> before and after compact()
+
+//EFFECTS: returns the ns per element of summing l, and adds the sum to
+//         checksum
+double traverse_ns(const List<int> &l, int size, long long &checksum) {
+  const int ROUNDS = 10;
+  long long start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) checksum += sum_all(l);
+  return double(now_ns() - start) / ROUNDS / size;
+}
+
+//EFFECTS: prints the traversal cost of a List<int> of size random ints whose
+//         nodes were scattered by sorting it, then after compacting it all
+//         at once and step by step
+void bench_compact(int size) {
+  const std::size_t STEP = 4096; //nodes per incremental step
+  long long checksum = 0;
+  List<int> l = random_list(size, 280);
+  l.compact();
+  double array_ns = traverse_ns(l, size, checksum);
+  l.sort(); //relinks the nodes in random memory order
+  double scattered_ns = traverse_ns(l, size, checksum);
+
+  List<int> other = random_list(size, 280);
+  other.compact();
+  other.sort();
+  long long start = now_ns();
+  other.compact();
+  long long full_ns = now_ns() - start;
+  double full_after_ns = traverse_ns(other, size, checksum);
+
+  start = now_ns();
+  long long steps = 0, max_step_ns = 0;
+  for (;;) {
+    long long step_start = now_ns();
+    std::size_t moved = l.compact(STEP);
+    max_step_ns = max(max_step_ns, now_ns() - step_start);
+    if (moved == 0) break;
+    ++steps;
+  }
+  long long incremental_ns = now_ns() - start;
+  double incremental_after_ns = traverse_ns(l, size, checksum);
+
+  BenchmarkRow().add("group", "compact")
+                .add("impl", "List<int>")
+                .add("size", size)
+                .add("contiguous_ns_per_elt", array_ns)
+                .add("scattered_ns_per_elt", scattered_ns)
+                .add("compact_ns_per_elt", double(full_ns) / size)
+                .add("after_compact_ns_per_elt", full_after_ns)
+                .add("steps", steps)
+                .add("max_step_ns", max_step_ns)
+                .add("incremental_ns_per_elt", double(incremental_ns) / size)
+                .add("after_incremental_ns_per_elt", incremental_after_ns)
+                .add("checksum", checksum)
+                .print(cout);
+}
+
+//REQUIRES: stride is the distance between elements in neighbouring slots
+//EFFECTS:  returns the number of steps from one element of l to the next
+//          that aren't to the next slot in memory
+std::size_t memory_jumps(const List<int> &l, std::ptrdiff_t stride) {
+  std::size_t jumps = 0;
+  const int *prev = 0;
+  for (List<int>::ConstIterator i = l.begin(); i != l.end(); ++i) {
+    if (prev && &*i - prev != stride) ++jumps;
+    prev = &*i;
+  }
+  return jumps;
+}
+
+// Two copies, each one block, merged so that every other node is from the
+// other block.  Incremental steps must move them all, not pass over every
+// change of block as already in place.
+void check_compact_interleaved() {
+  const int SIZE = 10000;
+  const std::size_t STEP = 100;
+  List<int> evens, odds;
+  for (int i = 0; i < SIZE; i += 2) {
+    evens.push_back(i);
+    odds.push_back(i + 1);
+  }
+  List<int> a(evens), b(odds); //one block each
+  const std::ptrdiff_t stride = &*++a.cbegin() - &*a.cbegin();
+  a.merge(std::move(b));
+  bench_check(memory_jumps(a, stride) == static_cast<std::size_t>(SIZE - 1),
+              "compact: merged list is interleaved");
+
+  std::size_t steps = 0;
+  while (a.compact(STEP) > 0) ++steps;
+  bench_check(steps == SIZE / STEP, "compact: steps");
+  bench_check(memory_jumps(a, stride) <= steps,
+              "compact: one jump per step at most");
+  int expected = 0;
+  for (List<int>::ConstIterator i = a.begin(); i != a.end(); ++i) {
+    bench_check(*i == expected++, "compact: contents");
+  }
+  bench_check(expected == SIZE, "compact: size");
+}
+
+// Move-only elements: compact() must move them, with no copy constructor
+void check_compact_move_only() {
+  const int SIZE = 1000;
+  List<unique_ptr<int> > l;
+  for (int i = 0; i < SIZE; ++i) l.push_back(unique_ptr<int>(new int(i)));
+  l.compact();
+  l.push_front(unique_ptr<int>(new int(-1)));
+  while (l.compact(100) > 0) {}
+  int expected = -1;
+  for (List<unique_ptr<int> >::ConstIterator i = l.begin(); i != l.end();
+       ++i) {
+    bench_check(**i == expected++, "compact: move-only contents");
+  }
+  bench_check(expected == SIZE, "compact: move-only size");
+}
+
+void bench_compact_group() {
+  check_compact_interleaved();
+  check_compact_move_only();
+  const int sizes[] = {10000, 1000000, 4000000};
+  for (int s = 0; s < 3; ++s) bench_compact(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// parallel: sequential loops against the algorithms of ParallelList.h
+
+// a predicate that costs about as much as a small hash, so that the work
+// per element outweighs the walk
+struct ExpensiveMatch {
+  int target;
+  explicit ExpensiveMatch(int target_in) : target(target_in) {}
+  bool operator() (int x) const {
+    unsigned h = static_cast<unsigned>(x);
+    for (int i = 0; i < 16; ++i) h = h * 2654435761u + 0x9e3779b9u;
+    return h == static_cast<unsigned>(target) * 2u + 1u || x == target;
+  }
+};
+
+//EFFECTS: prints the cost of reducing a List<int> of size elements, and of
+//         any_of() with a match half way through, sequentially and with
+//         pools of each size in threads
+void bench_parallel(int size) {
+  List<int> l;
+  for (int i = 0; i < size; ++i) l.push_back(i);
+  const int target = size / 2;
+  const int ROUNDS = 5;
+
+  long long checksum = 0;
+  long long start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    checksum += sum_all(l);
+    bool found = false;
+    ExpensiveMatch match(target);
+    for (List<int>::Iterator i = l.begin(); i != l.end() && !found; ++i) {
+      found = match(*i);
+    }
+    checksum += found;
+  }
+  double sequential_ns = double(now_ns() - start) / ROUNDS;
+  BenchmarkRow().add("group", "parallel")
+                .add("impl", "sequential")
+                .add("size", size)
+                .add("threads", 1)
+                .add("ns_per_round", sequential_ns)
+                .add("checksum", checksum)
+                .print(cout);
+
+  const unsigned threads[] = {0, 1, 3};
+  for (int t = 0; t < 3; ++t) {
+    WorkStealingPool pool(threads[t]);
+    checksum = 0;
+    start = now_ns();
+    ListChunks<List<int>::Iterator> chunks(l.begin(), l.end(),
+                                           4 * (pool.size() + 1));
+    long long chunk_ns = now_ns() - start;
+    for (int r = 0; r < ROUNDS; ++r) {
+      checksum += parallel_reduce(pool, chunks, 0LL, plus<long long>());
+      checksum += parallel_any_of(pool, chunks, ExpensiveMatch(target));
+    }
+    double parallel_ns = double(now_ns() - start - chunk_ns) / ROUNDS;
+    BenchmarkRow().add("group", "parallel")
+                  .add("impl", "WorkStealingPool")
+                  .add("size", size)
+                  .add("threads", static_cast<int>(pool.size() + 1))
+                  .add("chunks", static_cast<long long>(chunks.size()))
+                  .add("chunk_index_ns", chunk_ns)
+                  .add("ns_per_round", parallel_ns)
+                  .add("checksum", checksum)
+                  .print(cout);
+  }
+}
+
+// parallel_reduce() with T = bool, whose partial results must not share
+// words the way the elements of a vector<bool> do
+void check_parallel_reduce_bool() {
+  const int SIZE = 100000;
+  WorkStealingPool pool(3);
+  List<int> l;
+  for (int i = 0; i < SIZE; ++i) l.push_back(0);
+  for (int round = 0; round < 2; ++round) {
+    ListChunks<List<int>::Iterator> chunks(l.begin(), l.end(), 64);
+    for (int r = 0; r < 20; ++r) {
+      bool any = parallel_reduce(pool, chunks, false, logical_or<bool>());
+      bench_check(any == (round == 1), "parallel: reduce with bool");
+    }
+    l.back() = 1;
+  }
+}
+
+void bench_parallel_group() {
+  check_parallel_reduce_bool();
+  const int sizes[] = {10000, 1000000};
+  for (int s = 0; s < 2; ++s) bench_parallel(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// views: filter then transform, into new Lists against through ListViews.h
+
+struct InBand {
+  int lo, hi;
+  InBand(int lo_in, int hi_in) : lo(lo_in), hi(hi_in) {}
+  bool operator() (int x) const { return lo <= x && x <= hi; }
+};
+
+struct Square {
+  long long operator() (int x) const { return static_cast<long long>(x) * x; }
+};
+
+// counts its calls in a counter outside it, since views keep copies
+struct CountingIsZero {
+  long long *calls;
+  explicit CountingIsZero(long long *calls_in) : calls(calls_in) {}
+  bool operator() (int x) const { ++*calls; return x == 0; }
+};
+
+// take() must stop pulling from a filter once it has n elements, rather
+// than have the filter search the rest of the list for one more
+void check_take_stops() {
+  const int SIZE = 1000000;
+  List<int> l;
+  for (int i = 0; i < SIZE; ++i) l.push_back(i % 10 == 0 && i < 30 ? 0 : 1);
+
+  long long calls = 0;
+  long long sum = sum_all(take(filter(l, CountingIsZero(&calls)), 1));
+  bench_check(sum == 0 && calls == 1, "views: take 1 of a filter");
+
+  // the zeros are elements 0, 10 and 20
+  calls = 0;
+  long long n = 0;
+  FilterView<ContainerRef<List<int> >, CountingIsZero> zeros =
+    filter(l, CountingIsZero(&calls));
+  for (int x : take(zeros, 3)) n += 1 - x;
+  bench_check(n == 3 && calls == 21, "views: take 3 of a filter");
+}
+
+//EFFECTS: prints the cost of summing the squares of the elements of a
+//         random List<int> that fall in a band holding about half of them,
+//         first by building a filtered and a transformed List, then with
+//         views.  Then the same for only the first 100 matches.
+void bench_views(int size) {
+  List<int> l = random_list(size, 45);
+  InBand band(0, 1 << 30); //random_list() ints are below 1 << 31
+  const int ROUNDS = 5;
+  const size_t FIRST = 100;
+
+  for (int first_only = 0; first_only < 2; ++first_only) {
+    long long allocs_before = g_alloc_stats.allocs.load();
+    long long checksum = 0;
+    long long start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      List<int> kept;
+      size_t n = 0;
+      for (List<int>::Iterator i = l.begin(); i != l.end(); ++i) {
+        if (first_only && n == FIRST) break;
+        if (band(*i)) { kept.push_back(*i); ++n; }
+      }
+      List<long long> squares;
+      for (List<int>::Iterator i = kept.begin(); i != kept.end(); ++i) {
+        squares.push_back(Square()(*i));
+      }
+      checksum += sum_all(squares);
+    }
+    double eager_ns = double(now_ns() - start) / ROUNDS;
+    long long eager_allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+    allocs_before = g_alloc_stats.allocs.load();
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      if (first_only) {
+        checksum -= sum_all(take(transform(filter(l, band), Square()),
+                                 FIRST));
+      } else {
+        checksum -= sum_all(transform(filter(l, band), Square()));
+      }
+    }
+    double view_ns = double(now_ns() - start) / ROUNDS;
+    long long view_allocs = g_alloc_stats.allocs.load() - allocs_before;
+
+    string workload = first_only ? "first_100" : "all";
+    BenchmarkRow().add("group", "views")
+                  .add("impl", "new Lists")
+                  .add("workload", workload)
+                  .add("size", size)
+                  .add("ns_per_round", eager_ns)
+                  .add("allocs", eager_allocs)
+                  .print(cout);
+    BenchmarkRow().add("group", "views")
+                  .add("impl", "ListViews")
+                  .add("workload", workload)
+                  .add("size", size)
+                  .add("ns_per_round", view_ns)
+                  .add("allocs", view_allocs)
+                  .add("checksum", checksum) //0 if both agree
+                  .print(cout);
+  }
+}
+
+void bench_views_group() {
+  check_take_stops();
+  const int sizes[] = {1000, 1000000};
+  for (int s = 0; s < 2; ++s) bench_views(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// predicates: "solid or gas" as two passes, by hand, and combined
+
+//EFFECTS: returns the number of elements of l for which pred is true
+template <typename Predicate>
+long long count_matches(const List<int> &l, Predicate pred) {
+  long long n = 0;
+  for (List<int>::ConstIterator i = l.begin(); i != l.end(); ++i) {
+    n += pred(*i);
+  }
+  return n;
+}
+
+struct SolidOrGas {
+  bool operator() (int t) const { return t < 32 || t > 212; }
+};
+
+//EFFECTS: prints the cost per element of counting the temperatures in a
+//         List<int> of size elements that are below 32 or above 212
+void bench_predicates(int size) {
+  List<int> l;
+  mt19937 rng(46);
+  for (int i = 0; i < size; ++i) l.push_back(static_cast<int>(rng() % 300));
+  const int ROUNDS = 10;
+  LessN is_solid(32);
+  GreaterN is_gas(212);
+
+  for (int impl = 0; impl < 4; ++impl) {
+    long long count = 0;
+    long long start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      if (impl == 0) {
+        count += count_matches(l, is_solid) + count_matches(l, is_gas);
+      } else if (impl == 1) {
+        count += count_matches(l, SolidOrGas());
+      } else if (impl == 2) {
+        count += count_matches(l, is_solid || is_gas);
+      } else {
+        count += count_matches(l, or_(is_gas, InRange(INT_MIN, 31)));
+      }
+    }
+    double elapsed = double(now_ns() - start) / ROUNDS;
+    const char *names[] = {"two passes", "by hand", "is_solid || is_gas",
+                           "or_(GreaterN, InRange)"};
+    BenchmarkRow().add("group", "predicates")
+                  .add("impl", names[impl])
+                  .add("size", size)
+                  .add("ns_per_element", elapsed / size)
+                  .add("checksum", count)
+                  .print(cout);
+  }
+}
+
+void bench_predicates_group() {
+  const int sizes[] = {1000, 1000000};
+  for (int s = 0; s < 2; ++s) bench_predicates(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// batch: BatchPredicates.h against one call per element, over an int array
+
+//EFFECTS: prints one row of the batch group
+void print_batch_row(const string &op, const string &impl, int size,
+                     double ns, long long checksum) {
+  BenchmarkRow().add("group", "batch")
+                .add("op", op)
+                .add("impl", impl)
+                .add("size", size)
+                .add("ns_per_element", ns / size)
+                .add("checksum", checksum)
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of count_if, any_of, mask_of and partition over
+//         size temperatures, with SolidOrGas called once per element and
+//         with the vectorized kernels for is_solid || is_gas
+void bench_batch(int size) {
+  vector<int> temps(size);
+  mt19937 rng(47);
+  for (int i = 0; i < size; ++i) {
+    temps[i] = static_cast<int>(rng() % 500) - 100;
+  }
+  // any_of has to look at all of them but the last
+  vector<int> liquid(size, 96);
+  liquid[size - 1] = 300;
+  vector<uint64_t> mask((size + 63) / 64);
+  const int ROUNDS = 20;
+  IntOutside solid_or_gas = LessN(32) || GreaterN(212);
+
+  for (int batch = 0; batch < 2; ++batch) {
+    string impl = batch ? "batch is_solid || is_gas" : "SolidOrGas";
+    long long checksum = 0;
+    long long start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      checksum += batch ? batch_count_if(&temps[0], size, solid_or_gas)
+                        : batch_count_if(&temps[0], size, SolidOrGas());
+    }
+    print_batch_row("count_if", impl, size,
+                    double(now_ns() - start) / ROUNDS, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      checksum += batch ? batch_any_of(&liquid[0], size, solid_or_gas)
+                        : batch_any_of(&liquid[0], size, SolidOrGas());
+    }
+    print_batch_row("any_of", impl, size,
+                    double(now_ns() - start) / ROUNDS, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int r = 0; r < ROUNDS; ++r) {
+      if (batch) {
+        batch_mask_of(&temps[0], size, solid_or_gas, &mask[0]);
+      } else {
+        batch_mask_of(&temps[0], size, SolidOrGas(), &mask[0]);
+      }
+      checksum += static_cast<long long>(mask[r % mask.size()] & 0xffff);
+    }
+    print_batch_row("mask_of", impl, size,
+                    double(now_ns() - start) / ROUNDS, checksum);
+
+    // partition a fresh copy each round, so only the copies are timed twice
+    checksum = 0;
+    long long elapsed = 0;
+    for (int r = 0; r < ROUNDS; ++r) {
+      vector<int> copy(temps);
+      start = now_ns();
+      checksum += batch ? batch_partition(&copy[0], size, solid_or_gas)
+                        : partition(copy.begin(), copy.end(), SolidOrGas())
+                            - copy.begin();
+      elapsed += now_ns() - start;
+    }
+    print_batch_row("partition", batch ? impl : "std::partition", size,
+                    double(elapsed) / ROUNDS, checksum);
+  }
+}
+
+//EFFECTS: checks every function of BatchPredicates.h against pred called
+//         on each element of data
+template <typename Predicate>
+void check_batch_against_scalar(const vector<int> &data, Predicate pred) {
+  size_t n = data.size();
+  size_t count = 0;
+  vector<uint64_t> mask((n + 63) / 64, 0);
+  for (size_t i = 0; i < n; ++i) {
+    if (pred(data[i])) {
+      ++count;
+      mask[i / 64] |= uint64_t(1) << (i % 64);
+    }
+  }
+  bench_check(batch_count_if(&data[0], n, pred) == count, "batch: count_if");
+  bench_check(batch_any_of(&data[0], n, pred) == (count > 0), "batch: any_of");
+
+  vector<uint64_t> batch_mask(mask.size(), ~uint64_t(0));
+  batch_mask_of(&data[0], n, pred, &batch_mask[0]);
+  bench_check(batch_mask == mask, "batch: mask_of");
+
+  vector<int> parted(data);
+  size_t matches = batch_partition(&parted[0], n, pred);
+  bench_check(matches == count, "batch: partition count");
+  for (size_t i = 0; i < n; ++i) {
+    bench_check(pred(parted[i]) == (i < matches), "batch: partition order");
+  }
+  vector<int> before(data);
+  sort(before.begin(), before.end());
+  sort(parted.begin(), parted.end());
+  bench_check(parted == before, "batch: partition elements");
+}
+
+// Random predicates, including intervals wider than int and empty ones,
+// against data with INT_MIN and INT_MAX, at sizes that aren't a multiple
+// of BATCH_BLOCK
+void check_batch_random() {
+  mt19937 rng(470);
+  const long long WIDE = 1LL << 33; //well outside int
+  uniform_int_distribution<long long> bound(-WIDE, WIDE);
+  uniform_int_distribution<int> any_int(INT_MIN, INT_MAX);
+  uniform_int_distribution<int> small(-300, 300);
+  const int edges[] = {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX};
+
+  for (int round = 0; round < 200; ++round) {
+    vector<int> data(64 * (round % 4) + round % 67 + 1);
+    for (size_t i = 0; i < data.size(); ++i) {
+      int pick = rng() % 4;
+      data[i] = pick == 0 ? edges[rng() % 7] :
+                pick == 1 ? any_int(rng) : small(rng);
+    }
+    long long lo = bound(rng), hi = bound(rng);
+    if (round % 3 == 0) hi = lo + small(rng); //narrow, or empty
+    int limit = round % 5 == 0 ? edges[rng() % 7] : small(rng);
+
+    check_batch_against_scalar(data, IntInterval(lo, hi));
+    check_batch_against_scalar(data, IntOutside(lo, hi));
+    check_batch_against_scalar(data, IntInterval(-5, 1LL << 32));
+    check_batch_against_scalar(data, IntInterval(INT_MIN, INT_MAX));
+    check_batch_against_scalar(data, IntInterval(1, 0));
+    check_batch_against_scalar(data, IntOutside(1, 0));
+    check_batch_against_scalar(data, GreaterN(limit));
+    check_batch_against_scalar(data, LessN(limit));
+    check_batch_against_scalar(data, LessN(limit) || GreaterN(limit / 2));
+    check_batch_against_scalar(data, !InRange(limit / 2, limit / 2 + 10));
+  }
+}
+
+void bench_batch_group() {
+  check_batch_random();
+  const int sizes[] = {1000, 1000000};
+  for (int s = 0; s < 2; ++s) bench_batch(sizes[s]);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// classify: a histogram of buckets with if/else functors and RangeClassifier
+
+//EFFECTS: prints one row of the classify group
+void print_classify_row(const string &impl, int buckets, int size,
+                        double ns, long long checksum) {
+  BenchmarkRow().add("group", "classify")
+                .add("impl", impl)
+                .add("buckets", buckets)
+                .add("size", size)
+                .add("ns_per_element", ns / size)
+                .add("checksum", checksum)
+                .print(cout);
+}
+
+//EFFECTS: prints the cost of counting size random temperatures as solid,
+//         liquid or gas with the functors of 21_Functors.cpp, and with a
+//         RangeClassifier
+void bench_classify_phases(int size) {
+  vector<int> temps(size);
+  mt19937 rng(48);
+  for (int i = 0; i < size; ++i) {
+    temps[i] = static_cast<int>(rng() % 500) - 100;
+  }
+  const int ROUNDS = 10;
+  LessN is_solid(32);
+  GreaterN is_gas(212);
+  const int bounds[] = {32, 213};
+  RangeClassifier phase(bounds, 2);
+  vector<unsigned> buckets(size);
+
+  long long checksum = 0;
+  long long start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    long long counts[3] = {0, 0, 0};
+    for (int i = 0; i < size; ++i) {
+      if (is_solid(temps[i])) ++counts[0];
+      else if (is_gas(temps[i])) ++counts[2];
+      else ++counts[1];
+    }
+    checksum += counts[0] + 3 * counts[1] + 7 * counts[2];
+  }
+  print_classify_row("if/else functors", 3, size,
+                     double(now_ns() - start) / ROUNDS, checksum);
+
+  checksum = 0;
+  start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    vector<size_t> counts = phase.histogram(&temps[0], size);
+    checksum += counts[0] + 3 * counts[1] + 7 * counts[2];
+  }
+  print_classify_row("RangeClassifier::histogram", 3, size,
+                     double(now_ns() - start) / ROUNDS, checksum);
+
+  checksum = 0;
+  start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    phase.classify(&temps[0], size, &buckets[0]);
+    checksum += buckets[r];
+  }
+  print_classify_row("RangeClassifier::classify", 3, size,
+                     double(now_ns() - start) / ROUNDS, checksum);
+}
+
+//EFFECTS: prints the cost of classifying size random ints into buckets
+//         buckets, with std::upper_bound and with a RangeClassifier
+void bench_classify_many(int buckets, int size) {
+  vector<int> temps(size);
+  mt19937 rng(48);
+  for (int i = 0; i < size; ++i) temps[i] = static_cast<int>(rng() % 10000);
+  vector<int> bounds;
+  for (int k = 1; k < buckets; ++k) bounds.push_back(k * 10000 / buckets);
+  RangeClassifier classifier(&bounds[0], bounds.size());
+  const int ROUNDS = 10;
+
+  long long checksum = 0;
+  long long start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    vector<size_t> counts(buckets, 0);
+    for (int i = 0; i < size; ++i) {
+      ++counts[upper_bound(bounds.begin(), bounds.end(), temps[i])
+               - bounds.begin()];
+    }
+    checksum += counts[buckets / 2];
+  }
+  print_classify_row("std::upper_bound", buckets, size,
+                     double(now_ns() - start) / ROUNDS, checksum);
+
+  checksum = 0;
+  start = now_ns();
+  for (int r = 0; r < ROUNDS; ++r) {
+    checksum += classifier.histogram(&temps[0], size)[buckets / 2];
+  }
+  print_classify_row("RangeClassifier::histogram", buckets, size,
+                     double(now_ns() - start) / ROUNDS, checksum);
+}
+
+void bench_classify_group() {
+  const int sizes[] = {1000, 1000000};
+  for (int s = 0; s < 2; ++s) bench_classify_phases(sizes[s]);
+  const int buckets[] = {8, 64, 1024};
+  for (int b = 0; b < 3; ++b) bench_classify_many(buckets[b], 1000000);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[]) {
+  string group = (argc > 1) ? argv[1] : "all";
+  bool all = (group == "all");
+  bool ran = false;
+
+  if (all || group == "pool") { bench_pool(); ran = true; }
+  if (all || group == "unrolled") { bench_unrolled(); ran = true; }
+  if (all || group == "move") { bench_move(); ran = true; }
+  if (all || group == "splice") { bench_splice(); ran = true; }
+  if (all || group == "concurrent") { bench_concurrent(); ran = true; }
+  if (all || group == "lru") { bench_lru_group(); ran = true; }
+  if (all || group == "sort") { bench_sort_group(); ran = true; }
+  if (all || group == "duplicates") { bench_duplicates_group(); ran = true; }
+  if (all || group == "intrusive") { bench_intrusive_group(); ran = true; }
+  if (all || group == "immutable") { bench_immutable_group(); ran = true; }
+  if (all || group == "compact") { bench_compact_group(); ran = true; }
+  if (all || group == "parallel") { bench_parallel_group(); ran = true; }
+  if (all || group == "views") { bench_views_group(); ran = true; }
+  if (all || group == "predicates") { bench_predicates_group(); ran = true; }
+  if (all || group == "batch") { bench_batch_group(); ran = true; }
+  if (all || group == "classify") { bench_classify_group(); ran = true; }
+
+  if (!ran) {
+    cerr << "Unrecognized benchmark group `" << group << "'\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,246 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+/* MemoryStats.h
+ *
+ * Memory accounting for containers.  A MemoryStats object counts the
+ * allocations made on behalf of one container, or of all containers of a
+ * kind: live bytes and objects, number of allocations and frees, and the
+ * peak of live bytes.  Every MemoryStats adds itself to a process-wide
+ * registry, which memory_stats_print() dumps on demand.
+ *
+ * CountingAllocator adapts any standard allocator so that a container's
+ * allocations are counted:
+ *
+ *   MemoryStats list_stats("List<int>");
+ *   List<int, CountingAllocator<int> > l((CountingAllocator<int>(list_stats)));
+ *   ...
+ *   memory_stats_print(std::cout);
+ *
+ * Containers that allocate with new[] can call note_alloc() and
+ * note_free() themselves, like IntSet in 17_IntSet.cpp.
+ *
+ * The registry can be printed from any thread at any time.  By default a
+ * MemoryStats expects to be updated by one thread at a time, e.g. by the
+ * one container it belongs to, and updates cost a few plain loads and
+ * stores.  Counters created with shared = true can be updated by several
+ * threads at once, using atomic read-modify-write instructions, which
+ * cost several times more.
+ */
+
+#include <atomic>   //atomic
+#include <cstddef>  //size_t
+#include <iostream> //ostream
+#include <memory>   //allocator, allocator_traits
+#include <mutex>    //mutex, lock_guard
+#include "IntrusiveList.h" //IntrusiveList, ListHook
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// MemoryStats declaration
+class MemoryStats : public ListHook {
+  //OVERVIEW: allocation counters, listed in the process-wide registry for
+  //          as long as they exist
+ public:
+
+  //REQUIRES: name_in outlives this, e.g. a string literal
+  //EFFECTS:  creates zeroed counters called name_in and registers them.
+  //          Pass shared_in = true if more than one thread may update
+  //          them at the same time.
+  explicit MemoryStats(const char *name_in, bool shared_in = false);
+
+  //EFFECTS: removes these counters from the registry
+  ~MemoryStats();
+
+  //MODIFIES: this
+  //EFFECTS:  records an allocation of bytes holding objects objects
+  void note_alloc(std::size_t bytes, std::size_t objects);
+
+  //MODIFIES: this
+  //EFFECTS:  records that an allocation of bytes holding objects objects
+  //          was freed
+  void note_free(std::size_t bytes, std::size_t objects);
+
+  //EFFECTS: prints one line with the name and the counters
+  void print(std::ostream &os) const;
+
+  const char * get_name() const { return name; }
+  long long get_live_bytes() const { return live_bytes.load(); }
+  long long get_live_objects() const { return live_objects.load(); }
+  long long get_allocs() const { return allocs.load(); }
+  long long get_frees() const { return frees.load(); }
+  long long get_peak_bytes() const { return peak_bytes.load(); }
+
+ private:
+  //MODIFIES: counter
+  //EFFECTS:  adds n to counter, and returns the new value
+  long long add(std::atomic<long long> &counter, long long n);
+
+  const char *name;
+  bool shared;                         //updated by several threads at once
+  // Atomic even when not shared, so that the registry can read them from
+  // another thread.  Unshared updates use plain loads and stores.
+  std::atomic<long long> live_bytes;
+  std::atomic<long long> live_objects; //e.g. list nodes or array elements
+  std::atomic<long long> allocs;
+  std::atomic<long long> frees;
+  std::atomic<long long> peak_bytes;   //highest live_bytes so far
+
+  // counters are registered by address, so they can't be copied
+  MemoryStats(const MemoryStats &);
+  MemoryStats & operator= (const MemoryStats &);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Registry
+
+// every MemoryStats in the process, and the lock that guards the list
+struct MemoryStatsRegistry {
+  std::mutex lock;
+  IntrusiveList<MemoryStats> all;
+};
+
+//EFFECTS: returns the process-wide registry
+inline MemoryStatsRegistry & memory_stats_registry() {
+  static MemoryStatsRegistry registry;
+  return registry;
+}
+
+//EFFECTS: prints every registered MemoryStats, oldest first
+inline void memory_stats_print(std::ostream &os) {
+  MemoryStatsRegistry &registry = memory_stats_registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+  for (IntrusiveList<MemoryStats>::Iterator i = registry.all.begin();
+       i != registry.all.end(); ++i) {
+    i->print(os);
+  }
+}
+
+//EFFECTS: returns the counters for allocators that weren't given any
+inline MemoryStats & default_memory_stats() {
+  static MemoryStats unattributed("(unattributed)", true);
+  return unattributed;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// MemoryStats implementation
+
+inline MemoryStats::MemoryStats(const char *name_in, bool shared_in)
+  : name(name_in), shared(shared_in), live_bytes(0), live_objects(0),
+    allocs(0), frees(0), peak_bytes(0) {
+  MemoryStatsRegistry &registry = memory_stats_registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+  registry.all.push_back(*this);
+}
+
+inline MemoryStats::~MemoryStats() {
+  // unlink under the lock, before ~ListHook would do it without one
+  MemoryStatsRegistry &registry = memory_stats_registry();
+  std::lock_guard<std::mutex> guard(registry.lock);
+  unlink();
+}
+
+inline long long MemoryStats::add(std::atomic<long long> &counter,
+                                  long long n) {
+  if (shared) return counter.fetch_add(n, std::memory_order_relaxed) + n;
+  long long value = counter.load(std::memory_order_relaxed) + n;
+  counter.store(value, std::memory_order_relaxed);
+  return value;
+}
+
+inline void MemoryStats::note_alloc(std::size_t bytes, std::size_t objects) {
+  add(allocs, 1);
+  add(live_objects, objects);
+  long long live = add(live_bytes, bytes);
+  long long peak = peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !peak_bytes.compare_exchange_weak(peak, live,
+                                           std::memory_order_relaxed)) {}
+}
+
+inline void MemoryStats::note_free(std::size_t bytes, std::size_t objects) {
+  add(frees, 1);
+  add(live_objects, -static_cast<long long>(objects));
+  add(live_bytes, -static_cast<long long>(bytes));
+}
+
+inline void MemoryStats::print(std::ostream &os) const {
+  os << name << ": live_bytes=" << get_live_bytes()
+     << " live_objects=" << get_live_objects()
+     << " allocs=" << get_allocs()
+     << " frees=" << get_frees()
+     << " peak_bytes=" << get_peak_bytes() << "\n";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// CountingAllocator
+template <typename T, typename Base = std::allocator<T> >
+class CountingAllocator {
+  //OVERVIEW: standard allocator that gets memory from Base and records
+  //          every allocation in a MemoryStats
+ public:
+  typedef T value_type;
+
+  // containers rebind the allocator to their node type; Base goes along
+  template <typename U>
+  struct rebind {
+    typedef CountingAllocator<U,
+      typename std::allocator_traits<Base>::template rebind_alloc<U> > other;
+  };
+
+  //EFFECTS: creates an allocator that records into default_memory_stats()
+  CountingAllocator() : stats(&default_memory_stats()) {}
+
+  //REQUIRES: stats_in outlives every object allocated through this
+  //EFFECTS:  creates an allocator that records into stats_in
+  explicit CountingAllocator(MemoryStats &stats_in,
+                             const Base &base_in = Base())
+    : stats(&stats_in), base(base_in) {}
+
+  //EFFECTS: creates an allocator for T sharing the counters of other, and
+  //         a copy of its Base rebound to T
+  template <typename U, typename B>
+  CountingAllocator(const CountingAllocator<U, B> &other)
+    : stats(other.stats), base(other.base) {}
+
+  //EFFECTS: returns uninitialized memory for n objects of type T
+  T * allocate(std::size_t n) {
+    T *p = base.allocate(n);
+    stats->note_alloc(n * sizeof(T), n);
+    return p;
+  }
+
+  //REQUIRES: p was returned by allocate(n) on an allocator equal to this
+  //EFFECTS:  releases the memory at p
+  void deallocate(T *p, std::size_t n) {
+    stats->note_free(n * sizeof(T), n);
+    base.deallocate(p, n);
+  }
+
+  //EFFECTS: returns the counters this allocator records into
+  MemoryStats & get_stats() const { return *stats; }
+
+  //EFFECTS: returns true if memory from one allocator can be released by
+  //         the other, and is counted in the same MemoryStats
+  template <typename U, typename B>
+  bool operator== (const CountingAllocator<U, B> &rhs) const {
+    return stats == rhs.stats && base == rhs.base;
+  }
+
+  template <typename U, typename B>
+  bool operator!= (const CountingAllocator<U, B> &rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  MemoryStats *stats;
+  Base base;
+
+  template <typename U, typename B> friend class CountingAllocator;
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+/* NodePool.h
+ *
+ * Slab allocator for linked list nodes.  A NodePool hands out fixed-size
+ * blocks carved from large slabs and recycles freed blocks through a free
+ * list, so a push/pop cycle never reaches the global allocator.
+ *
+ * PoolAllocator adapts a NodePool to the standard allocator interface so it
+ * can be given to a container as a template parameter:
+ *
+ *   List<int, PoolAllocator<int> > l;           //thread-local shared pools
+ *
+ *   NodePool pool;
+ *   List<int, PoolAllocator<int> > l2((PoolAllocator<int>(pool)));  //own pool
+ *
+ * A default PoolAllocator takes each size of object from its own
+ * thread-local pool, so one allocator can serve elements and nodes of
+ * different sizes, and types of the same size, like the nodes of List<int>
+ * and List<float>, share a pool.  An allocator made from a NodePool uses that pool for
+ * everything; blocks bigger than the pool's come from operator new.
+ */
+
+#include <cassert>  //assert
+#include <cstddef>  //size_t, max_align_t
+#include <new>      //operator new, operator delete
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// NodePool declaration
+class NodePool {
+  //OVERVIEW: allocator for blocks of a single size.  The size is fixed by
+  //          the first call to allocate(); bigger requests are passed on to
+  //          operator new.  Pool memory goes back to the system only when
+  //          the pool is destroyed.
+ public:
+
+  //REQUIRES: first_slab_blocks > 0
+  //EFFECTS:  creates an empty pool whose first slab holds first_slab_blocks
+  //          blocks; each following slab is twice as big, up to a limit
+  NodePool(std::size_t first_slab_blocks = 64);
+
+  //REQUIRES: every block from this pool has been deallocated, or will not
+  //          be used again
+  //EFFECTS:  releases all slabs
+  ~NodePool();
+
+  //REQUIRES: size > 0
+  //MODIFIES: this
+  //EFFECTS:  returns a block of size bytes, aligned for any type.  It comes
+  //          from the pool if size is no bigger than the first size asked
+  //          for, and from operator new if it is.
+  void * allocate(std::size_t size);
+
+  //REQUIRES: p was returned by allocate(size) on this pool
+  //MODIFIES: this
+  //EFFECTS:  returns the block at p to the free list, or to operator delete
+  //          if it didn't come from the pool
+  void deallocate(void *p, std::size_t size);
+
+  //EFFECTS: returns the number of pool blocks currently handed out
+  std::size_t live_blocks() const { return live; }
+
+  //EFFECTS: returns the number of slabs taken from the global allocator
+  std::size_t slab_count() const { return slabs_allocated; }
+
+ private:
+  // A free block stores the link to the next free block in its own bytes
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  // Each slab starts with a header linking it to the previous slab
+  union SlabHeader {
+    SlabHeader *next;
+    std::max_align_t align;
+  };
+
+  static const std::size_t MAX_SLAB_BLOCKS = 4096;
+
+  FreeBlock *free_list;      //first free block, 0 if none
+  SlabHeader *slabs;         //most recent slab, 0 if none
+  std::size_t block_size;    //0 until the first allocate()
+  std::size_t next_slab_blocks;
+  std::size_t live;
+  std::size_t slabs_allocated;
+
+  //MODIFIES: this
+  //EFFECTS:  allocates a new slab and threads its blocks onto the free list
+  void grow();
+
+  // a pool owns its slabs, so it can't be copied
+  NodePool(const NodePool &);
+  NodePool & operator= (const NodePool &);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// NodePool implementation
+
+inline NodePool::NodePool(std::size_t first_slab_blocks)
+  : free_list(0), slabs(0), block_size(0),
+    next_slab_blocks(first_slab_blocks), live(0), slabs_allocated(0) {
+  assert(first_slab_blocks > 0);
+}
+
+inline NodePool::~NodePool() {
+  while (slabs) {
+    SlabHeader *victim = slabs;
+    slabs = slabs->next;
+    ::operator delete(victim);
+  }
+}
+
+inline void * NodePool::allocate(std::size_t size) {
+  if (block_size == 0) {
+    // round up so that every block stays aligned for any type
+    const std::size_t align = sizeof(SlabHeader);
+    block_size = (size + align - 1) / align * align;
+    if (block_size < sizeof(FreeBlock)) block_size = sizeof(FreeBlock);
+  }
+  assert(size > 0);
+  if (size > block_size) return ::operator new(size);
+
+  if (!free_list) grow();
+  FreeBlock *p = free_list;
+  free_list = free_list->next;
+  ++live;
+  return p;
+}
+
+inline void NodePool::deallocate(void *p, std::size_t size) {
+  assert(p);
+  if (size > block_size) {
+    ::operator delete(p);
+    return;
+  }
+  assert(live > 0);
+  FreeBlock *block = static_cast<FreeBlock *>(p);
+  block->next = free_list;
+  free_list = block;
+  --live;
+}
+
+inline void NodePool::grow() {
+  std::size_t n = next_slab_blocks;
+  char *raw = static_cast<char *>(
+    ::operator new(sizeof(SlabHeader) + n * block_size));
+  SlabHeader *slab = reinterpret_cast<SlabHeader *>(raw);
+  slab->next = slabs;
+  slabs = slab;
+  ++slabs_allocated;
+
+  // thread the blocks in address order, so that consecutive allocations
+  // are next to each other in memory
+  char *first = raw + sizeof(SlabHeader);
+  for (std::size_t i = n; i > 0; --i) {
+    FreeBlock *block = reinterpret_cast<FreeBlock *>(first + (i-1)*block_size);
+    block->next = free_list;
+    free_list = block;
+  }
+
+  if (next_slab_blocks < MAX_SLAB_BLOCKS) next_slab_blocks *= 2;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// PoolAllocator
+
+//EFFECTS: returns the calling thread's pool for blocks of SIZE bytes.  It
+//         is outside PoolAllocator, so that allocators of all types of the
+//         same size share it.
+template <std::size_t SIZE>
+NodePool & shared_size_pool() {
+  static thread_local NodePool pool;
+  return pool;
+}
+
+template <typename T>
+class PoolAllocator {
+  //OVERVIEW: standard allocator that takes single objects from a NodePool.
+  //          Requests for more than one object go to operator new.
+ public:
+  typedef T value_type;
+
+  //EFFECTS: creates an allocator using the calling thread's shared pool for
+  //         objects the size of T.  Objects must be deallocated on the
+  //         thread that allocated them, before that thread exits.
+  PoolAllocator() : pool(&thread_pool()), shared(true) {}
+
+  //REQUIRES: pool_in outlives every object allocated from it
+  //EFFECTS:  creates an allocator using pool_in, e.g. one pool per list
+  explicit PoolAllocator(NodePool &pool_in) : pool(&pool_in), shared(false) {}
+
+  //EFFECTS: creates an allocator for T from other.  Lists use this to turn
+  //         a PoolAllocator<T> into one for their nodes.  If other uses the
+  //         shared pools, this uses the shared pool for the size of T;
+  //         otherwise it uses the same pool as other.
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &other)
+    : pool(other.shared ? &thread_pool() : other.pool), shared(other.shared) {}
+
+  //EFFECTS: returns uninitialized memory for n objects of type T
+  T * allocate(std::size_t n) {
+    if (n == 1) return static_cast<T *>(pool->allocate(sizeof(T)));
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  //REQUIRES: p was returned by allocate(n) on an allocator equal to this
+  //EFFECTS:  releases the memory at p
+  void deallocate(T *p, std::size_t n) {
+    if (n == 1) pool->deallocate(p, sizeof(T));
+    else ::operator delete(p);
+  }
+
+  //EFFECTS: returns true if memory from one allocator can be released by
+  //         the other, once rebound to the same type
+  template <typename U>
+  bool operator== (const PoolAllocator<U> &rhs) const {
+    return shared ? rhs.shared : pool == rhs.pool;
+  }
+
+  template <typename U>
+  bool operator!= (const PoolAllocator<U> &rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  NodePool *pool;
+  bool shared; //pool is the thread's pool for sizeof(T)
+
+  template <typename U> friend class PoolAllocator;
+
+  //EFFECTS: returns the calling thread's pool for objects the size of T
+  static NodePool & thread_pool() {
+    return shared_size_pool<sizeof(T)>();
+  }
+};
+
+#endif
@@ -0,0 +1,392 @@
+#ifndef PARALLELLIST_H
+#define PARALLELLIST_H
+/* ParallelList.h
+ *
+ * Parallel algorithms over the elements of a List<T>, or of any container
+ * with an Iterator.
+ *
+ * A singly-linked list can't be cut into parts without walking it, so the
+ * cuts are made once, by a ListChunks index, and can be reused by any
+ * number of parallel passes as long as no element is inserted or removed:
+ *
+ *   WorkStealingPool pool(3);                    //3 threads + the caller
+ *   ListChunks<List<int>::Iterator> chunks(l.begin(), l.end(), 16);
+ *   parallel_for_each(pool, chunks, f);
+ *   long sum = parallel_reduce(pool, chunks, 0L, std::plus<long>());
+ *   bool any = parallel_any_of(pool, chunks, GreaterN(6));
+ *
+ * Each chunk is one task for the pool.  Every thread has its own queue of
+ * tasks, and a thread that runs out steals from the others, so a thread
+ * with slow elements doesn't hold up the rest.  parallel_any_of() stops
+ * every thread once one of them finds a match.
+ *
+ * Functors are copied for each chunk, so they may keep state, like the
+ * functors in 21_Functors.cpp, but they don't share it.
+ */
+
+#include <atomic>             //atomic
+#include <cassert>            //assert
+#include <condition_variable> //condition_variable
+#include <cstddef>            //size_t
+#include <deque>              //deque
+#include <exception>          //exception_ptr
+#include <mutex>              //mutex, lock_guard, unique_lock
+#include <thread>             //thread
+#include <vector>             //vector
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// WorkStealingPool declaration
+class WorkStealingPool {
+  //OVERVIEW: a set of worker threads that run batches of tasks.  The thread
+  //          that calls run() works on the batch too.
+ public:
+
+  //EFFECTS: starts threads worker threads.  By default, one fewer than the
+  //         number of processors, since the caller of run() makes up the
+  //         difference.
+  explicit WorkStealingPool(unsigned threads = default_threads());
+
+  //REQUIRES: no call to run() is in progress
+  //EFFECTS:  stops and joins the worker threads
+  ~WorkStealingPool();
+
+  //EFFECTS: returns the number of worker threads
+  unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+  //EFFECTS: calls task(i) for every i in [0, n), on the worker threads and
+  //         the calling thread, and returns when all calls are done.  If a
+  //         call throws, the tasks not yet started are skipped, and the
+  //         first exception is rethrown here.
+  template <typename Task>
+  void run(std::size_t n, Task task);
+
+  //EFFECTS: returns the default number of worker threads
+  static unsigned default_threads() {
+    unsigned cpus = std::thread::hardware_concurrency();
+    return cpus > 1 ? cpus - 1 : 0;
+  }
+
+ private:
+  // the tasks of one call to run()
+  struct Batch {
+    void (*call)(void *task, std::size_t i); //calls *task(i)
+    void *task;
+    std::atomic<std::size_t> remaining; //tasks not finished; changed
+                                        //under lock
+    std::atomic<bool> failed;
+    std::exception_ptr error;           //first exception thrown
+    std::mutex lock;
+    std::condition_variable done;       //signaled when remaining is 0
+  };
+
+  struct Job {
+    Batch *batch;
+    std::size_t index;
+  };
+
+  // one per worker thread.  The owner takes its newest job, thieves take
+  // the oldest.
+  struct Queue {
+    std::mutex lock;
+    std::deque<Job> jobs;
+  };
+
+  template <typename Task>
+  static void call_task(void *task, std::size_t i) {
+    (*static_cast<Task *>(task))(i);
+  }
+
+  //MODIFIES: this, the batch of job
+  //EFFECTS:  runs job, unless another task of its batch has failed, and
+  //          counts it as finished
+  void execute(const Job &job);
+
+  //MODIFIES: this
+  //EFFECTS:  runs the tasks of batch until none is left to take, then
+  //          waits for the rest to finish
+  void help(Batch &batch);
+
+  //MODIFIES: this, job
+  //EFFECTS:  takes a job, from queue me first if me is a queue, and returns
+  //          true, or returns false if every queue is empty
+  bool take(unsigned me, Job &job);
+
+  //EFFECTS: the loop of worker thread me
+  void work(unsigned me);
+
+  std::vector<std::thread> workers;
+  std::deque<Queue> queues; //one per worker, all made before the workers
+                            //start.  A deque, since Queue can't be moved.
+  std::atomic<std::size_t> queued; //jobs in all queues
+  bool stopping;                   //set under sleep_lock
+  std::mutex sleep_lock;
+  std::condition_variable wake;    //signaled when jobs are queued
+
+  // workers refer to the pool, so it can't be copied
+  WorkStealingPool(const WorkStealingPool &);
+  WorkStealingPool & operator= (const WorkStealingPool &);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ListChunks declaration
+template <typename Iterator>
+class ListChunks {
+  //OVERVIEW: cuts [begin, end) into chunks of the same length, except for
+  //          the last one, which may be shorter.  Valid until an element
+  //          of the range is inserted or removed.
+ public:
+
+  //REQUIRES: parts > 0
+  //EFFECTS:  cuts [begin, end) into at least parts and at most 2*parts
+  //          chunks, or one chunk per element if there are fewer.  Walks
+  //          the range once.
+  ListChunks(Iterator begin, Iterator end, std::size_t parts);
+
+  //EFFECTS: returns the number of chunks
+  std::size_t size() const { return bounds.size() - 1; }
+
+  //REQUIRES: i < size()
+  //EFFECTS:  returns the first element of chunk i
+  Iterator begin_of(std::size_t i) const { return bounds[i]; }
+
+  //REQUIRES: i < size()
+  //EFFECTS:  returns the end of chunk i, which is the first of chunk i+1
+  Iterator end_of(std::size_t i) const { return bounds[i + 1]; }
+
+ private:
+  std::vector<Iterator> bounds; //first element of each chunk, then end
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel algorithms
+
+//EFFECTS: calls f on every element, from the threads of pool
+template <typename Iterator, typename Function>
+void parallel_for_each(WorkStealingPool &pool,
+                       const ListChunks<Iterator> &chunks, Function f);
+
+//REQUIRES: op is associative, and op(identity, x) == x
+//EFFECTS:  returns op applied to identity and all elements in order, like
+//          a sequential loop would, from the threads of pool
+template <typename Iterator, typename T, typename BinaryOp>
+T parallel_reduce(WorkStealingPool &pool, const ListChunks<Iterator> &chunks,
+                  T identity, BinaryOp op);
+
+//EFFECTS: returns true if pred() returns true for any element, from the
+//         threads of pool.  All threads stop looking once one finds one.
+template <typename Iterator, typename Predicate>
+bool parallel_any_of(WorkStealingPool &pool,
+                     const ListChunks<Iterator> &chunks, Predicate pred);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// WorkStealingPool implementation
+
+inline WorkStealingPool::WorkStealingPool(unsigned threads)
+  : queues(threads), queued(0), stopping(false) {
+  for (unsigned i = 0; i < threads; ++i) {
+    workers.push_back(std::thread(&WorkStealingPool::work, this, i));
+  }
+}
+
+inline WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> guard(sleep_lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::size_t i = 0; i < workers.size(); ++i) workers[i].join();
+}
+
+template <typename Task>
+void WorkStealingPool::run(std::size_t n, Task task) {
+  if (n == 0) return;
+  Batch batch;
+  batch.call = &call_task<Task>;
+  batch.task = &task;
+  batch.remaining = n;
+  batch.failed = false;
+
+  if (size() == 0) {
+    // nobody to share with
+    for (std::size_t i = 0; i < n; ++i) execute(Job{&batch, i});
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      Queue &q = queues[i % queues.size()];
+      std::lock_guard<std::mutex> guard(q.lock);
+      q.jobs.push_back(Job{&batch, i});
+      ++queued;
+    }
+    // a worker either sees queued > 0 or is already waiting to be woken
+    { std::lock_guard<std::mutex> guard(sleep_lock); }
+    wake.notify_all();
+    help(batch);
+  }
+
+  if (batch.error) std::rethrow_exception(batch.error);
+}
+
+inline void WorkStealingPool::execute(const Job &job) {
+  Batch &batch = *job.batch;
+  if (!batch.failed.load(std::memory_order_relaxed)) {
+    try {
+      batch.call(batch.task, job.index);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(batch.lock);
+      if (!batch.error) batch.error = std::current_exception();
+      batch.failed = true;
+    }
+  }
+  // Under the lock, so that run() can't see 0, return and destroy the
+  // batch before we are done with it
+  std::lock_guard<std::mutex> guard(batch.lock);
+  if (--batch.remaining == 0) batch.done.notify_all();
+}
+
+inline void WorkStealingPool::help(Batch &batch) {
+  Job job;
+  while (batch.remaining.load() > 0 && take(size(), job)) execute(job);
+  std::unique_lock<std::mutex> guard(batch.lock);
+  while (batch.remaining.load() > 0) batch.done.wait(guard);
+}
+
+inline bool WorkStealingPool::take(unsigned me, Job &job) {
+  const unsigned n = size();
+  if (me < n) {
+    Queue &q = queues[me];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (!q.jobs.empty()) {
+      job = q.jobs.back();
+      q.jobs.pop_back();
+      --queued;
+      return true;
+    }
+  }
+  for (unsigned k = 1; k <= n; ++k) {
+    Queue &q = queues[(me + k) % n];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (!q.jobs.empty()) {
+      job = q.jobs.front();
+      q.jobs.pop_front();
+      --queued;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void WorkStealingPool::work(unsigned me) {
+  for (;;) {
+    Job job;
+    if (take(me, job)) {
+      execute(job);
+      continue;
+    }
+    std::unique_lock<std::mutex> guard(sleep_lock);
+    while (!stopping && queued.load() == 0) wake.wait(guard);
+    if (stopping && queued.load() == 0) return;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ListChunks implementation
+
+template <typename Iterator>
+ListChunks<Iterator>::ListChunks(Iterator begin, Iterator end,
+                                 std::size_t parts) {
+  assert(parts > 0);
+  // The length isn't known until the end.  Keep a bound every stride
+  // elements, and whenever there are 2*parts of them, drop every other one
+  // and double the stride.  The element that triggers this is 2*parts old
+  // strides in, so it is on the new stride too.
+  std::size_t stride = 1;
+  std::size_t skip = 0; //elements before the next bound
+  for (Iterator i = begin; i != end; ++i) {
+    if (skip > 0) {
+      --skip;
+      continue;
+    }
+    if (bounds.size() == 2 * parts) {
+      std::size_t kept = 0;
+      for (std::size_t b = 0; b < bounds.size(); b += 2) {
+        bounds[kept++] = bounds[b];
+      }
+      bounds.resize(kept);
+      stride *= 2;
+    }
+    bounds.push_back(i);
+    skip = stride - 1;
+  }
+  bounds.push_back(end);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel algorithm implementation
+
+template <typename Iterator, typename Function>
+void parallel_for_each(WorkStealingPool &pool,
+                       const ListChunks<Iterator> &chunks, Function f) {
+  pool.run(chunks.size(), [&chunks, &f](std::size_t c) {
+    Function local(f);
+    for (Iterator i = chunks.begin_of(c); i != chunks.end_of(c); ++i) {
+      local(*i);
+    }
+  });
+}
+
+// The result of one chunk of parallel_reduce().  A vector of these, unlike
+// a vector<T>, has an element of its own for each chunk even when T is
+// bool, so tasks on different threads never write to the same word.
+template <typename T>
+struct ReducePartial {
+  T value;
+  explicit ReducePartial(const T &value_in) : value(value_in) {}
+};
+
+template <typename Iterator, typename T, typename BinaryOp>
+T parallel_reduce(WorkStealingPool &pool, const ListChunks<Iterator> &chunks,
+                  T identity, BinaryOp op) {
+  std::vector<ReducePartial<T> > partial(chunks.size(),
+                                         ReducePartial<T>(identity));
+  pool.run(chunks.size(), [&chunks, &op, &partial](std::size_t c) {
+    BinaryOp local(op);
+    T result = partial[c].value;
+    for (Iterator i = chunks.begin_of(c); i != chunks.end_of(c); ++i) {
+      result = local(result, *i);
+    }
+    partial[c].value = result;
+  });
+  // combine in chunk order, so op needn't be commutative
+  T result = identity;
+  for (std::size_t c = 0; c < partial.size(); ++c) {
+    result = op(result, partial[c].value);
+  }
+  return result;
+}
+
+template <typename Iterator, typename Predicate>
+bool parallel_any_of(WorkStealingPool &pool,
+                     const ListChunks<Iterator> &chunks, Predicate pred) {
+  std::atomic<bool> found(false);
+  pool.run(chunks.size(), [&chunks, &pred, &found](std::size_t c) {
+    Predicate local(pred);
+    for (Iterator i = chunks.begin_of(c); i != chunks.end_of(c); ++i) {
+      // a plain load, cheap enough to do for every element
+      if (found.load(std::memory_order_relaxed)) return;
+      if (local(*i)) {
+        found.store(true, std::memory_order_relaxed);
+        return;
+      }
+    }
+  });
+  return found.load();
+}
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+/* Predicates.h
+ *
+ * The comparison functors used in 21_Functors.cpp, and combinators that
+ * join predicates into one:
+ *
+ *   LessN is_solid(32);
+ *   GreaterN is_gas(212);
+ *   any_of(l, is_solid || is_gas);     //one pass, one test per element
+ *   any_of(l, and_(is_gas, Odd()));    //any functors, with and_/or_/not_
+ *
+ * A combination is a functor whose type records how it was built, e.g.
+ * Or<LessN, InRange>, so that the compiler sees every test at once and
+ * can inline them into a single expression.
+ *
+ * Combinations of GreaterN, LessN and InRange are simplified when they are
+ * made.  These all test whether a value is in an interval, and so do their
+ * intersections and complements, so and_() of two of them is an IntInterval
+ * and not_() of one is an IntOutside.  LessN(32) || GreaterN(212) is
+ * IntOutside(32, 212).  Either one tests a value with a single unsigned
+ * comparison, however many functors went into it.
+ *
+ * The operators &&, || and ! only apply if one side is a predicate from
+ * this file.  Unlike the built-in ones, they don't short-circuit when the
+ * combination is made; the combination itself does when it is called.
+ */
+
+#include <climits>     //INT_MAX, INT_MIN
+#include <type_traits> //enable_if, is_base_of
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+// lo of an empty IntInterval: above every int, so no n is in [lo, lo]
+static const long long INT_INTERVAL_EMPTY_LO = INT_MAX + 1LL;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Intervals
+
+// base class of the predicates that can be combined with operators
+struct Combinable {};
+
+// base class of the predicates that are true on an interval of ints, and
+// have a member function interval() that returns it
+struct IntervalPredicate : public Combinable {};
+
+class IntInterval : public IntervalPredicate {
+  //OVERVIEW: functor returns true if input is in [lo, hi].  The interval
+  //          may be empty.
+public:
+  //EFFECTS: creates the interval [lo_in, hi_in], empty if hi_in < lo_in
+  IntInterval(long long lo_in, long long hi_in)
+  : lo(hi_in < lo_in ? INT_INTERVAL_EMPTY_LO : lo_in),
+    span(hi_in < lo_in ? 0 : hi_in - lo_in) {}
+
+  // n - lo can't overflow, and is below 0, so huge as unsigned, when n is
+  // below lo.  That makes it one comparison for both ends.
+  bool operator() (int n) const {
+    return static_cast<unsigned long long>(n - lo) <= span;
+  }
+
+  bool empty() const { return lo == INT_INTERVAL_EMPTY_LO; }
+
+  // lowest and highest values in the interval
+  // REQUIRES: interval is not empty
+  long long get_lo() const { return lo; }
+  long long get_hi() const { return lo + static_cast<long long>(span); }
+
+  IntInterval interval() const { return *this; }
+
+private:
+  long long lo;
+  unsigned long long span; //hi - lo
+};
+
+class IntOutside : public Combinable {
+  //OVERVIEW: functor returns true if input is not in an IntInterval
+public:
+  explicit IntOutside(const IntInterval &gap_in) : gap(gap_in) {}
+
+  //EFFECTS: creates a functor that is true outside [lo_in, hi_in]
+  IntOutside(long long lo_in, long long hi_in) : gap(lo_in, hi_in) {}
+
+  bool operator() (int n) const { return !gap(n); }
+
+  // the values where this is false
+  IntInterval get_gap() const { return gap; }
+
+private:
+  IntInterval gap;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Comparison functors
+
+class GreaterN : public IntervalPredicate {
+  //OVERVIEW: functor returns true if input is greater than limit
+  int limit;
+public:
+  GreaterN(int limit_in) : limit(limit_in) {}
+  bool operator() (int n) const { return n > limit; }
+  int get_limit() const { return limit; }
+  IntInterval interval() const { return IntInterval(limit + 1LL, INT_MAX); }
+};
+
+class LessN : public IntervalPredicate {
+  //OVERVIEW: functor returns true if input is less than limit
+  int limit;
+public:
+  LessN(int limit_in) : limit(limit_in) {}
+  bool operator() (int n) const { return n < limit; }
+  int get_limit() const { return limit; }
+  IntInterval interval() const { return IntInterval(INT_MIN, limit - 1LL); }
+};
+
+class InRange : public IntervalPredicate {
+  //OVERVIEW: functor returns true if input is within a range
+  int min, max;
+public:
+  InRange(int min_in, int max_in)
+  : min(min_in), max(max_in) {}
+
+  bool operator() (int n) const { return (min <= n) && (n <= max); }
+  IntInterval interval() const { return IntInterval(min, max); }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Combinations of any functors
+
+// Functors are members, and mutable, since functors may have a non-const
+// operator() that keeps state.
+
+template <typename P, typename Q>
+class And : public Combinable {
+  //OVERVIEW: functor returns true if both P and Q are true for input
+public:
+  And(const P &p_in, const Q &q_in) : p(p_in), q(q_in) {}
+
+  template <typename T>
+  bool operator() (const T &x) const { return p(x) && q(x); }
+
+private:
+  mutable P p;
+  mutable Q q;
+};
+
+template <typename P, typename Q>
+class Or : public Combinable {
+  //OVERVIEW: functor returns true if P or Q is true for input
+public:
+  Or(const P &p_in, const Q &q_in) : p(p_in), q(q_in) {}
+
+  template <typename T>
+  bool operator() (const T &x) const { return p(x) || q(x); }
+
+private:
+  mutable P p;
+  mutable Q q;
+};
+
+template <typename P>
+class Not : public Combinable {
+  //OVERVIEW: functor returns true if P is false for input
+public:
+  explicit Not(const P &p_in) : p(p_in) {}
+
+  template <typename T>
+  bool operator() (const T &x) const { return !p(x); }
+
+private:
+  mutable P p;
+};
+
+// IsInterval<P>::value is true if P is true on an interval of ints
+template <typename P>
+struct IsInterval : public std::is_base_of<IntervalPredicate, P> {};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Combinators
+
+//EFFECTS: returns a functor that is true if p and q are both true
+template <typename P, typename Q>
+typename std::enable_if<!(IsInterval<P>::value && IsInterval<Q>::value),
+                        And<P, Q> >::type
+and_(const P &p, const Q &q) {
+  return And<P, Q>(p, q);
+}
+
+//EFFECTS: returns the intersection of the intervals of p and q
+template <typename P, typename Q>
+typename std::enable_if<IsInterval<P>::value && IsInterval<Q>::value,
+                        IntInterval>::type
+and_(const P &p, const Q &q) {
+  IntInterval a = p.interval(), b = q.interval();
+  if (a.empty() || b.empty()) return a.empty() ? a : b;
+  return IntInterval(a.get_lo() > b.get_lo() ? a.get_lo() : b.get_lo(),
+                     a.get_hi() < b.get_hi() ? a.get_hi() : b.get_hi());
+}
+
+//EFFECTS: returns a functor that is true if p or q is true
+template <typename P, typename Q>
+Or<P, Q> or_(const P &p, const Q &q) {
+  return Or<P, Q>(p, q);
+}
+
+// The values below one limit or above another are the ones outside the
+// range in between.  If the two overlap, that range is empty, and the
+// result is true everywhere.
+inline IntOutside or_(const LessN &p, const GreaterN &q) {
+  return IntOutside(p.get_limit(), q.get_limit());
+}
+
+inline IntOutside or_(const GreaterN &p, const LessN &q) {
+  return or_(q, p);
+}
+
+//EFFECTS: returns a functor that is true if p is false
+template <typename P>
+typename std::enable_if<!IsInterval<P>::value, Not<P> >::type
+not_(const P &p) {
+  return Not<P>(p);
+}
+
+//EFFECTS: returns the complement of the interval of p
+template <typename P>
+typename std::enable_if<IsInterval<P>::value, IntOutside>::type
+not_(const P &p) {
+  return IntOutside(p.interval());
+}
+
+inline IntInterval not_(const IntOutside &p) {
+  return p.get_gap();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Operators
+
+// true if P or Q is a predicate from this file, so that the operators
+// don't apply to anything else
+template <typename P, typename Q>
+struct EitherCombinable {
+  static const bool value = std::is_base_of<Combinable, P>::value ||
+                            std::is_base_of<Combinable, Q>::value;
+};
+
+template <typename P, typename Q>
+auto operator&& (const P &p, const Q &q)
+  -> typename std::enable_if<EitherCombinable<P, Q>::value,
+                             decltype(and_(p, q))>::type {
+  return and_(p, q);
+}
+
+template <typename P, typename Q>
+auto operator|| (const P &p, const Q &q)
+  -> typename std::enable_if<EitherCombinable<P, Q>::value,
+                             decltype(or_(p, q))>::type {
+  return or_(p, q);
+}
+
+template <typename P>
+auto operator! (const P &p)
+  -> typename std::enable_if<std::is_base_of<Combinable, P>::value,
+                             decltype(not_(p))>::type {
+  return not_(p);
+}
+
+#endif
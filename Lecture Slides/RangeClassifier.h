@@ -0,0 +1,159 @@
+#ifndef RANGECLASSIFIER_H
+#define RANGECLASSIFIER_H
+/* RangeClassifier.h
+ *
+ * Sorts ints into buckets separated by thresholds, e.g. temperatures into
+ * solid, liquid and gas:
+ *
+ *   int bounds[] = {32, 213};           //solid < 32 <= liquid < 213 <= gas
+ *   RangeClassifier phase(bounds, 2);
+ *   phase(96);                          //1, liquid
+ *   std::vector<std::size_t> counts = phase.histogram(readings, n);
+ *
+ * The functors in 21_Functors.cpp would test is_solid, is_liquid and is_gas
+ * one after the other, and branch on each result, which the processor
+ * guesses wrong about as often as the data is unpredictable.  Here the
+ * bucket of a value is the number of thresholds at or below it, which is
+ * counted without branches.
+ *
+ * With up to RANGE_LINEAR_MAX thresholds, a value is compared with every
+ * one of them, and the batch functions do so for a block of values at a
+ * time, which g++ -O2 compiles to vector compares, as in
+ * BatchPredicates.h.  With more thresholds, each value takes a binary
+ * search whose loop depends only on the number of thresholds, with a
+ * conditional move instead of a branch at each step.
+ */
+
+#include <cassert>   //assert
+#include <cstddef>   //size_t
+#include <vector>    //vector
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+// classifiers with this many thresholds or fewer compare with all of them
+static const int RANGE_LINEAR_MAX = 16;
+
+// values classified together by the batch functions
+static const int RANGE_BLOCK = 64;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// RangeClassifier declaration
+class RangeClassifier {
+  //OVERVIEW: maps an int to the index of its bucket.  With thresholds
+  //          t[0] < t[1] < ... < t[n-1], bucket 0 holds the values below
+  //          t[0], bucket i the values in [t[i-1], t[i]), and bucket n the
+  //          values at or above t[n-1].
+ public:
+
+  //REQUIRES: thresholds_in[0..n) is sorted in increasing order
+  //EFFECTS:  creates a classifier with n + 1 buckets
+  RangeClassifier(const int thresholds_in[], std::size_t n);
+
+  //EFFECTS: returns the number of buckets
+  std::size_t size() const { return thresholds.size() + 1; }
+
+  //EFFECTS: returns the bucket of x
+  std::size_t operator() (int x) const;
+
+  //MODIFIES: buckets
+  //EFFECTS:  sets buckets[i] to the bucket of data[i], for i in [0, n)
+  void classify(const int data[], std::size_t n, unsigned buckets[]) const;
+
+  //EFFECTS: returns the number of elements of data[0..n) in each bucket
+  std::vector<std::size_t> histogram(const int data[], std::size_t n) const;
+
+ private:
+  //MODIFIES: buckets
+  //EFFECTS:  sets buckets[j] to the bucket of block[j], for j in
+  //          [0, RANGE_BLOCK), by comparing with every threshold
+  void classify_block(const int block[], unsigned buckets[]) const;
+
+  std::vector<int> thresholds;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// RangeClassifier implementation
+
+inline RangeClassifier::RangeClassifier(const int thresholds_in[],
+                                        std::size_t n)
+  : thresholds(thresholds_in, thresholds_in + n) {
+  for (std::size_t i = 1; i < n; ++i) {
+    assert(thresholds[i - 1] < thresholds[i]);
+  }
+}
+
+inline std::size_t RangeClassifier::operator() (int x) const {
+  std::size_t n = thresholds.size();
+  if (n == 0) return 0;
+  if (n <= static_cast<std::size_t>(RANGE_LINEAR_MAX)) {
+    std::size_t bucket = 0;
+    for (std::size_t k = 0; k < n; ++k) bucket += (thresholds[k] <= x);
+    return bucket;
+  }
+
+  // Binary search for the last threshold <= x.  The loop runs log2(n)
+  // times whatever x is, and the ?: compiles to a conditional move.
+  const int *base = &thresholds[0];
+  while (n > 1) {
+    std::size_t half = n / 2;
+    base = (base[half] <= x) ? base + half : base;
+    n -= half;
+  }
+  return (base - &thresholds[0]) + (*base <= x);
+}
+
+inline void RangeClassifier::classify_block(const int block[],
+                                            unsigned buckets[]) const {
+  // One threshold against the whole block, with no early exit.  The sums
+  // are local so that the compiler knows they don't overlap block.
+  unsigned sums[RANGE_BLOCK] = {};
+  for (std::size_t k = 0; k < thresholds.size(); ++k) {
+    const int t = thresholds[k];
+    for (int j = 0; j < RANGE_BLOCK; ++j) sums[j] += (t <= block[j]);
+  }
+  for (int j = 0; j < RANGE_BLOCK; ++j) buckets[j] = sums[j];
+}
+
+inline void RangeClassifier::classify(const int data[], std::size_t n,
+                                      unsigned buckets[]) const {
+  std::size_t i = 0;
+  if (thresholds.size() <= static_cast<std::size_t>(RANGE_LINEAR_MAX)) {
+    for (; i + RANGE_BLOCK <= n; i += RANGE_BLOCK) {
+      classify_block(data + i, buckets + i);
+    }
+  }
+  for (; i < n; ++i) buckets[i] = static_cast<unsigned>((*this)(data[i]));
+}
+
+inline std::vector<std::size_t>
+RangeClassifier::histogram(const int data[], std::size_t n) const {
+  std::vector<std::size_t> counts(size(), 0);
+  std::size_t i = 0;
+  if (thresholds.size() <= static_cast<std::size_t>(RANGE_LINEAR_MAX)) {
+    // at_least[k] counts the values >= thresholds[k].  Bucket k holds the
+    // values counted for thresholds[k - 1] but not for thresholds[k].
+    std::vector<std::size_t> at_least(thresholds.size(), 0);
+    for (; i + RANGE_BLOCK <= n; i += RANGE_BLOCK) {
+      for (std::size_t k = 0; k < thresholds.size(); ++k) {
+        const int t = thresholds[k];
+        unsigned block_count = 0;
+        for (int j = 0; j < RANGE_BLOCK; ++j) {
+          block_count += (t <= data[i + j]);
+        }
+        at_least[k] += block_count;
+      }
+    }
+    std::size_t below = i; //values counted so far
+    for (std::size_t k = 0; k < thresholds.size(); ++k) {
+      counts[k] = below - at_least[k];
+      below = at_least[k];
+    }
+    counts[thresholds.size()] = below;
+  }
+  for (; i < n; ++i) ++counts[(*this)(data[i])];
+  return counts;
+}
+
+#endif
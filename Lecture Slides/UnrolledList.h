@@ -0,0 +1,323 @@
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+/* UnrolledList.h
+ *
+ * Unrolled linked list: a singly-linked, double-ended list where each node
+ * holds a cache-line-sized block of elements instead of just one.  It has
+ * the same interface as List in 20_List_with_Iterator.h, but traversal
+ * touches a new cache line only once per block, and there is one next
+ * pointer per block rather than per element.
+ */
+
+#include <cassert>  //assert
+#include <new>      //placement new
+// NOTE: don't add "using namespace std;" in a .h file.  It pollutes the global
+// namespace for every program that includes this file.
+
+
+////////////////////////////////////////////////////////////////////////////////
+// UnrolledList declaration
+template <typename T>
+class UnrolledList {
+  //OVERVIEW: a singly-linked list of blocks of elements
+ public:
+
+  //EFFECTS:  returns true if the list is empty
+  bool empty() const;
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the first element in the list
+  T & front() const;
+
+  //REQUIRES: list is not empty
+  //EFFECTS: Returns a reference to the last element in the list
+  T & back() const;
+
+  //MODIFIES: this
+  //EFFECTS:  inserts datum into the front of the list
+  void push_front(const T &datum);
+
+  //MODIFIES: this
+  //EFFECTS:  inserts datum into the back of the list
+  void push_back(const T &datum);
+
+  //REQUIRES: list is not empty
+  //MODIFIES: this
+  //EFFECTS:  removes the item at the front of the list
+  void pop_front();
+
+  //default constructor and Big Three
+  UnrolledList();
+  UnrolledList(const UnrolledList &other);
+  ~UnrolledList();
+  UnrolledList & operator=(const UnrolledList &rhs);
+
+  //number of elements in one node, enough to fill a 64-byte cache line
+  static const int NODE_CAPACITY = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+
+ private:
+  //a private type.  The elements in use are data[first] through
+  //data[first+count-1]; the other slots hold no object.
+  struct Node {
+    Node *next;
+    int first;
+    int count;
+    alignas(T) unsigned char storage[NODE_CAPACITY * sizeof(T)];
+
+    T * data() { return reinterpret_cast<T *>(storage); }
+  };
+
+  //REQUIRES: 0 <= slot < NODE_CAPACITY
+  //EFFECTS: returns a new unlinked Node holding a copy of datum in slot
+  Node * create_node(int slot, const T &datum);
+
+  //MODIFIES: this
+  //EFFECTS:  copies all elements from other to the back of this
+  void push_all(const UnrolledList &other);
+
+  //MODIFIES: this
+  //EFFECTS:  removes all elements
+  void pop_all();
+
+  Node *front_ptr; //pointer to the first Node in the list, 0 for empty list
+  Node *back_ptr;  //pointer to the last Node in the list, 0 for empty list
+
+ public:
+  ////////////////////////////////////////
+  class Iterator {
+    //OVERVIEW: Iterator interface to UnrolledList
+   public:
+
+    // create a default Iterator, which points "past the end"
+    Iterator() : node_ptr(0), index(0) {}
+
+    // get the T at the current Iterator position
+    T& operator* () const {
+      assert(node_ptr);
+      return node_ptr->data()[index];
+    }
+
+    // return the address of the element at the current position
+    T* operator-> () const {
+      assert(node_ptr);
+      return node_ptr->data() + index;
+    }
+
+    // move Iterator to next position (prefix)
+    // REQUIRES: Iterator is not at default position
+    Iterator& operator++ () {
+      assert(node_ptr);
+      if (++index == node_ptr->first + node_ptr->count) {
+        node_ptr = node_ptr->next;
+        index = node_ptr ? node_ptr->first : 0;
+      }
+      return *this;
+    }
+
+    // move Iterator to next position (postfix)
+    Iterator operator++ (int) {
+      Iterator tmp(*this);
+      ++*this;
+      return tmp; //Note: returns a copy!  This is how postfix works.
+    }
+
+    // compare two Iterator objects by their position
+    bool operator!= (Iterator rhs) const {
+      return node_ptr != rhs.node_ptr || index != rhs.index;
+    }
+
+    // compare two Iterator objects by their position
+    bool operator== (Iterator rhs) const {
+      return !(*this != rhs);
+    }
+
+   private:
+    Node *node_ptr; //current block, 0 past the end
+    int index;      //current slot within the block
+    friend class UnrolledList;
+
+    // construct an Iterator at a specific position
+    Iterator(Node *p, int index_in) : node_ptr(p), index(index_in) {}
+  };//UnrolledList::Iterator
+
+  ////////////////////////////////////////
+  class ConstIterator {
+    //OVERVIEW: Iterator interface to a const UnrolledList, read-only
+   public:
+
+    // create a default ConstIterator, which points "past the end"
+    ConstIterator() {}
+
+    // an Iterator converts to a ConstIterator, but not the other way round
+    ConstIterator(Iterator it_in) : it(it_in) {}
+
+    const T& operator* () const { return *it; }
+    const T* operator-> () const { return it.operator->(); }
+
+    ConstIterator& operator++ () {
+      ++it;
+      return *this;
+    }
+
+    ConstIterator operator++ (int) {
+      ConstIterator tmp(*this);
+      ++it;
+      return tmp;
+    }
+
+    // compare by position; either side may be an Iterator
+    friend bool operator!= (ConstIterator lhs, ConstIterator rhs) {
+      return lhs.it != rhs.it;
+    }
+
+    friend bool operator== (ConstIterator lhs, ConstIterator rhs) {
+      return lhs.it == rhs.it;
+    }
+
+   private:
+    Iterator it;
+  };//UnrolledList::ConstIterator
+
+  // return an Iterator pointing to the first element
+  Iterator begin() {
+    return front_ptr ? Iterator(front_ptr, front_ptr->first) : Iterator();
+  }
+
+  // return an Iterator pointing to "past the end"
+  Iterator end() {
+    return Iterator();
+  }
+
+  // the elements of a const UnrolledList can only be read
+  ConstIterator begin() const {
+    return front_ptr ? Iterator(front_ptr, front_ptr->first) : Iterator();
+  }
+
+  ConstIterator end() const {
+    return Iterator();
+  }
+
+};//UnrolledList
+
+
+////////////////////////////////////////////////////////////////////////////////
+// UnrolledList implementation
+
+template <typename T>
+bool UnrolledList<T>::empty() const {
+  return front_ptr == 0;
+}
+
+template <typename T>
+T & UnrolledList<T>::front() const {
+  assert(!empty());
+  return front_ptr->data()[front_ptr->first];
+}
+
+template <typename T>
+T & UnrolledList<T>::back() const {
+  assert(!empty());
+  return back_ptr->data()[back_ptr->first + back_ptr->count - 1];
+}
+
+template <typename T>
+void UnrolledList<T>::push_front(const T &datum) {
+  if (!empty() && front_ptr->first > 0) {
+    new (front_ptr->data() + front_ptr->first - 1) T(datum);
+    --front_ptr->first;
+    ++front_ptr->count;
+    return;
+  }
+
+  // no room in front of the first block, start a new one filled from its
+  // end so that later push_front() calls can use the rest of it
+  Node *p = create_node(NODE_CAPACITY - 1, datum);
+  p->next = front_ptr;
+  if (empty()) back_ptr = p;
+  front_ptr = p;
+}
+
+template <typename T>
+void UnrolledList<T>::push_back(const T &datum) {
+  if (!empty() && back_ptr->first + back_ptr->count < NODE_CAPACITY) {
+    new (back_ptr->data() + back_ptr->first + back_ptr->count) T(datum);
+    ++back_ptr->count;
+    return;
+  }
+
+  Node *p = create_node(0, datum);
+  if (empty()) {
+    front_ptr = back_ptr = p;
+  } else {
+    back_ptr->next = p;
+    back_ptr = p;
+  }
+}
+
+template <typename T>
+typename UnrolledList<T>::Node *
+UnrolledList<T>::create_node(int slot, const T &datum) {
+  Node *p = new Node;
+  try {
+    new (p->data() + slot) T(datum);
+  } catch (...) {
+    delete p; //don't leave an empty block behind
+    throw;
+  }
+  p->next = 0;
+  p->first = slot;
+  p->count = 1;
+  return p;
+}
+
+template <typename T>
+void UnrolledList<T>::pop_front() {
+  assert(!empty());
+  front_ptr->data()[front_ptr->first].~T();
+  ++front_ptr->first;
+  if (--front_ptr->count == 0) {
+    Node *victim = front_ptr;
+    front_ptr = front_ptr->next;
+    if (empty()) back_ptr = 0;
+    delete victim; victim=0;
+  }
+}
+
+template <typename T>
+void UnrolledList<T>::pop_all() {
+  while (!empty()) {
+    pop_front();
+  }
+}
+
+template <typename T>
+void UnrolledList<T>::push_all(const UnrolledList &other) {
+  for (ConstIterator i = other.begin(); i != other.end(); ++i) {
+    push_back(*i);
+  }
+}
+
+template <typename T>
+UnrolledList<T>::UnrolledList()
+  : front_ptr(0), back_ptr(0) {}
+
+template <typename T>
+UnrolledList<T>::~UnrolledList() {
+  pop_all();
+}
+
+template <typename T>
+UnrolledList<T>::UnrolledList(const UnrolledList &other)
+  : front_ptr(0), back_ptr(0) {
+  push_all(other);
+}
+
+template <typename T>
+UnrolledList<T> & UnrolledList<T>::operator= (const UnrolledList &rhs) {
+  if (this == &rhs) return *this;
+  pop_all();
+  push_all(rhs);
+  return *this;
+}
+
+#endif